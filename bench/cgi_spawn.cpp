@@ -0,0 +1,87 @@
+/*===============================================================*/
+// spawns/second of the CGI process creation paths
+//
+// usage: cgi_spawn [iterations] [ballast MiB] [program]
+//  - fork        : fork + execve, what CgiHandler::execute used to do
+//  - posix_spawn : Spawner::spawn
+// ballast is heap touched before measuring, to show how fork slows
+// down as the server process grows while posix_spawn does not
+/*===============================================================*/
+
+#include <signal.h>
+#include <spawn.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+extern char** environ;
+
+static double now(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static pid_t spawnWithFork(char* const argv[]) {
+  pid_t pid = fork();
+  if (pid == 0) {
+    execve(argv[0], argv, environ);
+    _exit(EXIT_FAILURE);
+  }
+  return pid;
+}
+
+static pid_t spawnWithPosixSpawn(char* const argv[]) {
+  pid_t pid;
+  if (posix_spawn(&pid, argv[0], NULL, NULL, argv, environ) != 0) {
+    return -1;
+  }
+  return pid;
+}
+
+static void measure(const std::string& name, pid_t (*spawn)(char* const[]),
+                    char* const argv[], int iterations) {
+  double start = now();
+  for (int i = 0; i < iterations; ++i) {
+    pid_t pid = spawn(argv);
+    if (pid == -1) {
+      std::cerr << name << ": spawn failed: " << std::strerror(errno)
+                << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    waitpid(pid, NULL, 0);
+  }
+  double elapsed = now() - start;
+  std::cout << std::left << std::setw(12) << name << std::right
+            << std::setw(10) << std::fixed << std::setprecision(0)
+            << iterations / elapsed << " spawns/s" << std::setw(10)
+            << std::setprecision(1) << elapsed * 1e6 / iterations
+            << " us/spawn" << std::endl;
+}
+
+int main(int argc, char** argv) {
+  int iterations = (argc > 1) ? std::atoi(argv[1]) : 2000;
+  std::size_t ballast_mib = (argc > 2) ? std::atoi(argv[2]) : 256;
+  char* program = (argc > 3) ? argv[3] : const_cast<char*>("/usr/bin/true");
+  char* const child_argv[] = {program, NULL};
+
+  std::vector<char> ballast(ballast_mib << 20);
+  for (std::size_t i = 0; i < ballast.size(); i += 4096) {
+    ballast[i] = 1;
+  }
+  signal(SIGCHLD, SIG_DFL);
+
+  std::cout << iterations << " x " << program << ", " << ballast_mib
+            << " MiB resident" << std::endl;
+  measure("fork", spawnWithFork, child_argv, iterations);
+  measure("posix_spawn", spawnWithPosixSpawn, child_argv, iterations);
+  return EXIT_SUCCESS;
+}
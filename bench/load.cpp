@@ -0,0 +1,647 @@
+/*===============================================================*/
+// HTTP/1.1 load generator
+//
+// usage: load [-c connections] [-n requests | -d seconds] [-p depth]
+//             [-K] [-t timeout] [-s seed] [-r spec]... host:port
+//  - connections : open at once, each reconnects when it is closed
+//  - requests    : stop after that many, otherwise run for seconds
+//  - depth       : requests written ahead of their responses
+//                  (pipelining), 1 waits for each response
+//  - K           : Connection: close, one request per connection
+//  - spec        : "[weight*]METHOD PATH [body bytes]", requests are
+//                  drawn by weight from a seeded generator so a run
+//                  repeats the same mix. "GET /" when none is given
+// one thread polls every connection without blocking. the latency of
+// a request runs from when it is queued on its connection until its
+// response is complete, and is reported as percentiles
+/*===============================================================*/
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Request {
+  std::size_t weight;
+  std::string method;
+  std::string message;
+};
+
+struct Options {
+  Options()
+      : connections(16),
+        requests(0),
+        duration(10),
+        depth(1),
+        keep_alive(true),
+        timeout(10),
+        seed(1){};
+
+  std::string host;
+  std::string port;
+  std::size_t connections;
+  std::size_t requests;
+  double duration;
+  std::size_t depth;
+  bool keep_alive;
+  double timeout;
+  uint32_t seed;
+  std::vector<Request> mix;
+};
+
+struct InFlight {
+  double started;
+  bool is_head;
+};
+
+struct Connection {
+  Connection() : fd(-1), is_connecting(false), sent(0), is_closing(false){};
+
+  int fd;
+  bool is_connecting;
+  std::string output;
+  std::size_t sent;
+  std::string input;
+  std::deque<InFlight> in_flight;
+  bool is_closing;
+};
+
+struct Stats {
+  Stats()
+      : issued(0),
+        connect_errors(0),
+        read_errors(0),
+        timeouts(0),
+        bad_responses(0),
+        bytes(0) {
+    std::fill(statuses, statuses + 6, 0);
+  }
+
+  std::size_t issued;
+  std::vector<double> latencies;
+  std::size_t statuses[6];
+  std::size_t connect_errors;
+  std::size_t read_errors;
+  std::size_t timeouts;
+  std::size_t bad_responses;
+  uint64_t bytes;
+};
+
+static const std::size_t READ_SIZE = 64 * 1024;
+static const int POLL_INTERVAL = 50;
+static const std::size_t CONNECT_ATTEMPTS = 16;
+
+static Options options;
+static Stats stats;
+static struct sockaddr_storage address;
+static socklen_t address_len;
+static uint32_t random_state;
+static std::size_t total_weight;
+
+static double now(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void fail(const std::string& message) {
+  std::cerr << "load: " << message << std::endl;
+  std::exit(EXIT_FAILURE);
+}
+
+/*======================//
+ options
+========================*/
+
+static void usage(void) {
+  fail(
+      "usage: load [-c connections] [-n requests | -d seconds] [-p depth] "
+      "[-K] [-t timeout] [-s seed] [-r spec]... host:port");
+}
+
+/* "[weight*]METHOD PATH [body bytes]" */
+static Request parseSpec(const std::string& spec) {
+  Request request;
+  std::string rest = spec;
+  std::string path;
+  std::size_t body_size = 0;
+
+  request.weight = 1;
+  std::size_t star = rest.find_first_not_of("0123456789");
+  if (star != 0 && star != std::string::npos && rest[star] == '*') {
+    request.weight = std::strtoul(rest.c_str(), NULL, 10);
+    rest = rest.substr(star + 1);
+  }
+  std::vector<std::string> words;
+  std::size_t pos = 0;
+  while (pos < rest.size()) {
+    std::size_t end = rest.find(' ', pos);
+    if (end == std::string::npos) {
+      end = rest.size();
+    }
+    if (end != pos) {
+      words.push_back(rest.substr(pos, end - pos));
+    }
+    pos = end + 1;
+  }
+  if (request.weight == 0 || words.size() < 2 || words.size() > 3) {
+    fail("bad request spec: " + spec);
+  }
+  request.method = words[0];
+  path = words[1];
+  if (words.size() == 3) {
+    body_size = std::strtoul(words[2].c_str(), NULL, 10);
+  }
+
+  request.message = request.method + " " + path + " HTTP/1.1\r\n";
+  request.message += "Host: " + options.host + "\r\n";
+  request.message += "User-Agent: webserv-load\r\n";
+  if (options.keep_alive == false) {
+    request.message += "Connection: close\r\n";
+  }
+  if (body_size != 0 || request.method == "POST") {
+    std::ostringstream length;
+    length << body_size;
+    request.message += "Content-Type: application/octet-stream\r\n";
+    request.message += "Content-Length: " + length.str() + "\r\n";
+  }
+  request.message += "\r\n";
+  request.message.append(body_size, 'x');
+  return request;
+}
+
+static void parseOptions(int argc, char** argv) {
+  std::vector<std::string> specs;
+  int option;
+
+  while ((option = getopt(argc, argv, "c:n:d:p:Kt:s:r:")) != -1) {
+    switch (option) {
+      case 'c':
+        options.connections = std::strtoul(optarg, NULL, 10);
+        break;
+      case 'n':
+        options.requests = std::strtoul(optarg, NULL, 10);
+        break;
+      case 'd':
+        options.duration = std::strtod(optarg, NULL);
+        break;
+      case 'p':
+        options.depth = std::strtoul(optarg, NULL, 10);
+        break;
+      case 'K':
+        options.keep_alive = false;
+        break;
+      case 't':
+        options.timeout = std::strtod(optarg, NULL);
+        break;
+      case 's':
+        options.seed = std::strtoul(optarg, NULL, 10);
+        break;
+      case 'r':
+        specs.push_back(optarg);
+        break;
+      default:
+        usage();
+    }
+  }
+  if (optind + 1 != argc || options.connections == 0 ||
+      options.depth == 0 || options.duration <= 0) {
+    usage();
+  }
+  std::string target = argv[optind];
+  std::size_t colon = target.rfind(':');
+  if (colon == std::string::npos) {
+    usage();
+  }
+  options.host = target.substr(0, colon);
+  options.port = target.substr(colon + 1);
+  if (options.keep_alive == false) {
+    options.depth = 1;
+  }
+  if (specs.empty() == true) {
+    specs.push_back("GET /");
+  }
+  for (std::size_t i = 0; i < specs.size(); ++i) {
+    options.mix.push_back(parseSpec(specs[i]));
+    total_weight += options.mix.back().weight;
+  }
+}
+
+static void resolve(void) {
+  struct addrinfo hints;
+  struct addrinfo* result;
+
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  int error = getaddrinfo(options.host.c_str(), options.port.c_str(), &hints,
+                          &result);
+  if (error != 0) {
+    fail(options.host + ": " + gai_strerror(error));
+  }
+  std::memcpy(&address, result->ai_addr, result->ai_addrlen);
+  address_len = result->ai_addrlen;
+  freeaddrinfo(result);
+}
+
+/*======================//
+ responses
+========================*/
+
+static bool startsWithIgnoreCase(const std::string& line,
+                                 const std::string& prefix) {
+  if (line.size() < prefix.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < prefix.size(); ++i) {
+    if (std::tolower(line[i]) != prefix[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* the length of the chunked body at pos, 0 while incomplete */
+static std::size_t measureChunked(const std::string& input, std::size_t pos) {
+  while (true) {
+    std::size_t line_end = input.find("\r\n", pos);
+    if (line_end == std::string::npos) {
+      return 0;
+    }
+    std::size_t size = std::strtoul(input.c_str() + pos, NULL, 16);
+    pos = line_end + 2;
+    if (size == 0) {
+      std::size_t end = input.find("\r\n", pos);
+      if (end == std::string::npos) {
+        return 0;
+      }
+      if (end == pos) {
+        return end + 2;
+      }
+      end = input.find("\r\n\r\n", pos);
+      return (end == std::string::npos) ? 0 : end + 4;
+    }
+    if (input.size() < pos + size + 2) {
+      return 0;
+    }
+    pos += size + 2;
+  }
+}
+
+/* the length of the first response in input, 0 while incomplete and
+std::string::npos if it is not HTTP. a body without length ends with
+the connection, until_close tells the caller to wait for that */
+static std::size_t measureResponse(const std::string& input, bool is_head,
+                                   int& status, bool& until_close,
+                                   bool& is_close) {
+  std::size_t header_end = input.find("\r\n\r\n");
+  if (header_end == std::string::npos) {
+    return 0;
+  }
+  if (input.compare(0, 5, "HTTP/") != 0 || input.size() < 12) {
+    return std::string::npos;
+  }
+  status = std::atoi(input.c_str() + 9);
+
+  std::size_t content_length = std::string::npos;
+  bool is_chunked = false;
+  std::size_t pos = input.find("\r\n") + 2;
+  while (pos < header_end) {
+    std::size_t end = input.find("\r\n", pos);
+    std::string line = input.substr(pos, end - pos);
+    if (startsWithIgnoreCase(line, "content-length:") == true) {
+      content_length = std::strtoul(line.c_str() + 15, NULL, 10);
+    } else if (startsWithIgnoreCase(line, "transfer-encoding:") == true &&
+               line.find("chunked") != std::string::npos) {
+      is_chunked = true;
+    } else if (startsWithIgnoreCase(line, "connection:") == true &&
+               line.find("close") != std::string::npos) {
+      is_close = true;
+    }
+    pos = end + 2;
+  }
+
+  std::size_t body = header_end + 4;
+  until_close = false;
+  if (is_head == true || status == 204 || status == 304 || status < 200) {
+    return body;
+  }
+  if (is_chunked == true) {
+    return measureChunked(input, body);
+  }
+  if (content_length == std::string::npos) {
+    until_close = true;
+    return 0;
+  }
+  return (input.size() < body + content_length) ? 0 : body + content_length;
+}
+
+static void complete(Connection& connection, int status) {
+  stats.latencies.push_back(now() - connection.in_flight.front().started);
+  stats.statuses[(status / 100 <= 5) ? status / 100 : 0] += 1;
+  connection.in_flight.pop_front();
+}
+
+/*======================//
+ connections
+========================*/
+
+static void connectTo(Connection& connection) {
+  int fd = socket(address.ss_family, SOCK_STREAM, 0);
+  if (fd == -1) {
+    fail(std::string("socket: ") + std::strerror(errno));
+  }
+  int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+
+  connection.fd = fd;
+  connection.is_connecting = false;
+  connection.is_closing = false;
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+              address_len) == -1) {
+    if (errno != EINPROGRESS) {
+      stats.connect_errors += 1;
+      close(fd);
+      connection.fd = -1;
+      return;
+    }
+    connection.is_connecting = true;
+  }
+}
+
+/* requests still in flight on a closed connection failed */
+static void reset(Connection& connection, std::size_t& errors) {
+  errors += connection.in_flight.size();
+  connection.in_flight.clear();
+  if (connection.fd != -1) {
+    close(connection.fd);
+  }
+  connection.fd = -1;
+  connection.output.clear();
+  connection.sent = 0;
+  connection.input.clear();
+}
+
+static bool canIssue(double deadline) {
+  if (options.requests != 0) {
+    return stats.issued < options.requests;
+  }
+  return now() < deadline;
+}
+
+static const Request& pick(void) {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  std::size_t point = random_state % total_weight;
+  for (std::size_t i = 0; i < options.mix.size(); ++i) {
+    if (point < options.mix[i].weight) {
+      return options.mix[i];
+    }
+    point -= options.mix[i].weight;
+  }
+  return options.mix.back();
+}
+
+static void fill(Connection& connection, double deadline) {
+  if (connection.is_closing == true) {
+    return;
+  }
+  while (connection.in_flight.size() < options.depth &&
+         canIssue(deadline) == true) {
+    const Request& request = pick();
+    InFlight in_flight;
+    in_flight.started = now();
+    in_flight.is_head = (request.method == "HEAD");
+    connection.in_flight.push_back(in_flight);
+    connection.output += request.message;
+    stats.issued += 1;
+    if (options.keep_alive == false) {
+      connection.is_closing = true;
+      break;
+    }
+  }
+}
+
+static void sendRequests(Connection& connection) {
+  while (connection.sent < connection.output.size()) {
+    ssize_t sent = ::send(connection.fd,
+                          connection.output.c_str() + connection.sent,
+                          connection.output.size() - connection.sent, 0);
+    if (sent == -1) {
+      if (errno != EAGAIN) {
+        reset(connection, stats.read_errors);
+      }
+      return;
+    }
+    connection.sent += sent;
+  }
+  connection.output.clear();
+  connection.sent = 0;
+}
+
+static void receiveResponses(Connection& connection) {
+  char buffer[READ_SIZE];
+  bool is_eof = false;
+
+  while (true) {
+    ssize_t received = recv(connection.fd, buffer, READ_SIZE, 0);
+    if (received == 0) {
+      is_eof = true;
+      break;
+    }
+    if (received == -1) {
+      if (errno != EAGAIN) {
+        is_eof = true;
+      }
+      break;
+    }
+    stats.bytes += received;
+    connection.input.append(buffer, received);
+  }
+
+  while (connection.in_flight.empty() == false) {
+    int status = 0;
+    bool until_close = false;
+    bool is_close = false;
+    std::size_t length =
+        measureResponse(connection.input, connection.in_flight.front().is_head,
+                        status, until_close, is_close);
+    if (length == std::string::npos) {
+      reset(connection, stats.bad_responses);
+      return;
+    }
+    if (until_close == true && is_eof == true) {
+      length = connection.input.size();
+    }
+    if (length == 0) {
+      break;
+    }
+    complete(connection, status);
+    connection.input.erase(0, length);
+    if (is_close == true) {
+      is_eof = true;
+      break;
+    }
+  }
+  if (is_eof == true || (connection.is_closing == true &&
+                         connection.in_flight.empty() == true)) {
+    reset(connection, stats.read_errors);
+  }
+}
+
+/* the oldest request of a connection waited too long */
+static void expire(Connection& connection, double time) {
+  if (connection.in_flight.empty() == false &&
+      time - connection.in_flight.front().started > options.timeout) {
+    reset(connection, stats.timeouts);
+  }
+}
+
+/*======================//
+ run
+========================*/
+
+static double run(std::vector<Connection>& connections) {
+  std::vector<struct pollfd> fds(connections.size());
+  double start = now();
+  double deadline = start + options.duration;
+
+  while (true) {
+    bool is_busy = false;
+    for (std::size_t i = 0; i < connections.size(); ++i) {
+      Connection& connection = connections[i];
+      if (connection.fd == -1 && canIssue(deadline) == true) {
+        connectTo(connection);
+      }
+      if (connection.fd != -1 && connection.is_connecting == false) {
+        fill(connection, deadline);
+      }
+      if (connection.in_flight.empty() == false) {
+        is_busy = true;
+      }
+      fds[i].fd = connection.fd;
+      fds[i].events = POLLIN;
+      if (connection.is_connecting == true ||
+          connection.output.empty() == false) {
+        fds[i].events |= POLLOUT;
+      }
+      fds[i].revents = 0;
+    }
+    if (is_busy == false && canIssue(deadline) == false) {
+      break;
+    }
+    if (stats.latencies.empty() == true &&
+        stats.connect_errors >= CONNECT_ATTEMPTS * connections.size()) {
+      fail("can not connect to " + options.host + ":" + options.port);
+    }
+    if (poll(&fds[0], fds.size(), POLL_INTERVAL) == -1 && errno != EINTR) {
+      fail(std::string("poll: ") + std::strerror(errno));
+    }
+
+    double time = now();
+    for (std::size_t i = 0; i < connections.size(); ++i) {
+      Connection& connection = connections[i];
+      short revents = fds[i].revents;
+      if (connection.fd == -1) {
+        continue;
+      }
+      if (connection.is_connecting == true && revents != 0) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0) {
+          stats.connect_errors += 1;
+          reset(connection, stats.read_errors);
+          continue;
+        }
+        connection.is_connecting = false;
+        continue;
+      }
+      if (revents & POLLOUT) {
+        sendRequests(connection);
+      }
+      if (connection.fd != -1 && (revents & (POLLIN | POLLHUP | POLLERR))) {
+        receiveResponses(connection);
+      }
+      if (connection.fd != -1) {
+        expire(connection, time);
+      }
+    }
+    /* give up on requests left when the time is over */
+    if (options.requests == 0 && time > deadline + options.timeout) {
+      break;
+    }
+  }
+  return now() - start;
+}
+
+static double percentile(const std::vector<double>& sorted, double q) {
+  if (sorted.empty() == true) {
+    return 0;
+  }
+  std::size_t rank = static_cast<std::size_t>(q * sorted.size());
+  return sorted[std::min(rank, sorted.size() - 1)] * 1e3;
+}
+
+static void report(double elapsed) {
+  std::vector<double>& latencies = stats.latencies;
+  std::sort(latencies.begin(), latencies.end());
+  double sum = 0;
+  for (std::size_t i = 0; i < latencies.size(); ++i) {
+    sum += latencies[i];
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "requests  " << latencies.size() << " in " << elapsed
+            << " s, " << latencies.size() / elapsed << " req/s, "
+            << stats.bytes / elapsed / (1 << 20) << " MiB/s" << std::endl;
+  std::cout << "status    1xx " << stats.statuses[1] << " 2xx "
+            << stats.statuses[2] << " 3xx " << stats.statuses[3] << " 4xx "
+            << stats.statuses[4] << " 5xx " << stats.statuses[5]
+            << std::endl;
+  std::cout << "errors    connect " << stats.connect_errors << " read "
+            << stats.read_errors << " timeout " << stats.timeouts
+            << " malformed " << stats.bad_responses << std::endl;
+  std::cout << std::setprecision(3) << "latency   mean "
+            << (latencies.empty() ? 0 : sum / latencies.size() * 1e3)
+            << " p50 " << percentile(latencies, 0.5) << " p90 "
+            << percentile(latencies, 0.9) << " p99 "
+            << percentile(latencies, 0.99) << " p999 "
+            << percentile(latencies, 0.999) << " max "
+            << percentile(latencies, 1) << " ms" << std::endl;
+}
+
+int main(int argc, char** argv) {
+  parseOptions(argc, argv);
+  resolve();
+  signal(SIGPIPE, SIG_IGN);
+  random_state = options.seed ? options.seed : 1;
+
+  std::vector<Connection> connections(options.connections);
+  double elapsed = run(connections);
+  for (std::size_t i = 0; i < connections.size(); ++i) {
+    reset(connections[i], stats.read_errors);
+  }
+  report(elapsed);
+  return (stats.latencies.empty() == true) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
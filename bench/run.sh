@@ -0,0 +1,117 @@
+#!/bin/sh
+#=================================================================
+# load scenarios against a webserv serving bench/bench.conf
+#
+# usage: bench/run.sh [scenario...]
+#   DURATION seconds per scenario (5), PORT to listen on (8787)
+# every scenario starts a fresh server on fixtures made in a
+# temporary directory, so one run does not weigh on the next. the
+# server runs from that directory since CGI scripts are looked up
+# from the working directory, with links to conf, html and static.
+# scenarios: small large autoindex cgi notfound upload mixed close
+#=================================================================
+
+set -e
+cd "$(dirname "$0")/.."
+REPO=$(pwd)
+
+DURATION=${DURATION:-5}
+PORT=${PORT:-8787}
+LOAD=bench/load
+WEBSERV=$REPO/webserv
+PYTHON=$(command -v python3 || true)
+SCENARIOS=${*:-"small large autoindex cgi notfound upload mixed close"}
+
+if [ ! -x "$WEBSERV" ] || [ ! -x "$LOAD" ]; then
+	echo "bench: build webserv and bench/load first (make bench-run)" >&2
+	exit 1
+fi
+
+ROOT=$(mktemp -d)
+PID=
+cleanup() {
+	[ -n "$PID" ] && kill "$PID" 2>/dev/null
+	rm -rf "$ROOT"
+}
+trap cleanup EXIT INT TERM
+
+#======================// fixtures ========================
+
+mkdir -p "$ROOT/www" "$ROOT/listing" "$ROOT/cgi-bin"
+for dir in conf html static; do
+	ln -s "$REPO/$dir" "$ROOT/$dir"
+done
+head -c 1024 /dev/zero | tr '\0' 'a' > "$ROOT/www/small.html"
+dd if=/dev/zero of="$ROOT/www/large.bin" bs=1048576 count=8 2>/dev/null
+i=0
+while [ $i -lt 200 ]; do
+	: > "$ROOT/listing/file$i.txt"
+	i=$((i + 1))
+done
+cat > "$ROOT/cgi-bin/hello.py" <<'EOF'
+import sys
+sys.stdout.write("Content-Type: text/plain\r\n\r\nhello\n")
+EOF
+cat > "$ROOT/cgi-bin/upload.py" <<'EOF'
+import sys
+size = len(sys.stdin.buffer.read())
+sys.stdout.write("Content-Type: text/plain\r\n\r\n%d\n" % size)
+EOF
+sed -e "s|@ROOT@|$ROOT|g" -e "s|@PORT@|$PORT|g" \
+	-e "s|@PYTHON@|${PYTHON:-/usr/bin/python3}|g" \
+	bench/bench.conf > "$ROOT/bench.conf"
+
+#======================// server ========================
+
+start() {
+	(cd "$ROOT" && exec "$WEBSERV" bench.conf) > "$ROOT/webserv.log" 2>&1 &
+	PID=$!
+	tries=0
+	until "$LOAD" -c 1 -n 1 -r "GET /status" "127.0.0.1:$PORT" \
+		> /dev/null 2>&1; do
+		tries=$((tries + 1))
+		if [ $tries -ge 50 ]; then
+			echo "bench: webserv did not start, see below" >&2
+			cat "$ROOT/webserv.log" >&2
+			exit 1
+		fi
+		sleep 0.1
+	done
+}
+
+stop() {
+	kill "$PID" 2>/dev/null
+	wait "$PID" 2>/dev/null || true
+	PID=
+}
+
+scenario() {
+	name=$1
+	shift
+	case " $SCENARIOS " in
+	*" $name "*) ;;
+	*) return 0 ;;
+	esac
+	echo "== $name: $*"
+	start
+	"$LOAD" -d "$DURATION" "$@" "127.0.0.1:$PORT" || true
+	stop
+	echo
+}
+
+#======================// scenarios ========================
+
+scenario small -c 32 -r "GET /small.html"
+scenario large -c 8 -r "GET /large.bin"
+scenario autoindex -c 16 -r "GET /listing/"
+scenario notfound -c 32 -r "GET /missing.html"
+scenario close -K -c 32 -r "GET /small.html"
+if [ -n "$PYTHON" ]; then
+	scenario cgi -c 8 -r "GET /cgi-bin/hello.py"
+	scenario upload -c 8 -r "POST /cgi-bin/upload.py 65536"
+	scenario mixed -c 32 -r "8*GET /small.html" -r "GET /large.bin" \
+		-r "2*GET /missing.html" -r "GET /listing/" \
+		-r "GET /cgi-bin/hello.py"
+else
+	echo "bench: no python3, skipping cgi, upload and mixed" >&2
+fi
@@ -0,0 +1,58 @@
+import io
+import os
+import runpy
+import sys
+
+# persistent CGI worker for CGI_POOL_WORKER
+# reads "<length>\n<payload>" frames from stdin, runs the requested script
+# with the frame's environment and body, and answers with a frame of its output
+
+def readFrame(stream):
+	line = stream.readline()
+	if not line:
+		return None
+	return stream.read(int(line))
+
+def writeFrame(stream, payload):
+	stream.write(str(len(payload)).encode() + b"\n" + payload)
+	stream.flush()
+
+def parseEnviron(header):
+	environ = {}
+	for line in header.decode().split("\n"):
+		key, _, value = line.partition("=")
+		environ[key] = value
+	return environ
+
+def runScript(environ, body):
+	script = environ["PATH_TRANSLATED"]
+	output = io.BytesIO()
+	failure = None
+	stdin, stdout, path = sys.stdin, sys.stdout, list(sys.path)
+
+	os.environ.clear()
+	os.environ.update(BASE_ENVIRON)
+	os.environ.update(environ)
+	sys.stdin = io.TextIOWrapper(io.BytesIO(body))
+	sys.stdout = io.TextIOWrapper(output, write_through=True)
+	sys.path.insert(0, os.path.dirname(script))
+	try:
+		runpy.run_path(script, run_name="__main__")
+	except SystemExit:
+		pass
+	except Exception:
+		failure = b"Status: 500 Internal Server Error\n\n"
+	finally:
+		sys.stdout.flush()
+		result = output.getvalue()
+		sys.stdin, sys.stdout, sys.path = stdin, stdout, path
+	return failure or result
+
+BASE_ENVIRON = dict(os.environ)
+
+while True:
+	payload = readFrame(sys.stdin.buffer)
+	if payload is None:
+		break
+	header, _, body = payload.partition(b"\n\n")
+	writeFrame(sys.stdout.buffer, runScript(parseEnviron(header), body))
@@ -0,0 +1,79 @@
+#ifndef ACCESS_LOG_HPP_
+#define ACCESS_LOG_HPP_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "LogFile.hpp"
+
+class Client;
+
+/* access log of a virtual server */
+class AccessLog {
+ public:
+  AccessLog();
+  AccessLog(const std::string& path, const std::string& format);
+  AccessLog(const AccessLog& origin);
+  AccessLog& operator=(const AccessLog& origin);
+  ~AccessLog();
+
+  void write(const Client& client) const;
+
+  static std::string escape(const std::string& value);
+  static std::string toSeconds(uint64_t microseconds);
+
+ private:
+  enum Mode { M_TEXT, M_JSON, M_BINARY };
+  enum Handler { H_STATIC, H_CGI, H_PROXY };
+
+  enum Variable {
+    V_LITERAL,
+    V_REMOTE_ADDR,
+    V_TIME_LOCAL,
+    V_REQUEST,
+    V_REQUEST_METHOD,
+    V_REQUEST_URI,
+    V_STATUS,
+    V_BYTES_SENT,
+    V_REQUEST_TIME,
+    V_HOST,
+    V_HTTP,
+  };
+
+  struct Token {
+    Token(Variable variable, const std::string& text)
+        : variable(variable), text(text){};
+
+    Variable variable;
+    std::string text;
+  };
+
+  void compile(const std::string& format);
+  void addVariable(const std::string& name);
+  std::string renderText(const Client& client) const;
+  static std::string render(const Token& token, const Client& client);
+  static std::string renderJson(const Client& client);
+  static std::string renderBinary(const Client& client);
+
+  static Handler getHandler(const Client& client);
+  static std::string getTarget(const Client& client);
+  static std::string escapeJson(const std::string& value);
+  static void putInteger(std::string& record, uint64_t value,
+                         std::size_t size);
+  static void putText(std::string& record, const std::string& text,
+                      std::size_t size);
+
+  static const char* const VARIABLES[];
+  static const char* const HANDLERS[];
+  static const std::string HTTP_PREFIX;
+  static const std::size_t BINARY_VERSION = 1;
+  static const std::size_t BINARY_RECORD_SIZE = 256;
+
+  Mode mode_;
+  LogFile* file_;
+  std::vector<Token> tokens_;
+};
+
+#endif
@@ -8,7 +8,9 @@
 #include <exception>
 #include <string>
 
+#include "Clock.hpp"
 #include "HttpRequest.hpp"
+#include "Metrics.hpp"
 #include "Response.hpp"
 #include "ResponseGenerator.hpp"
 #include "ServerManager.hpp"
@@ -41,24 +43,34 @@ class Client {
   HttpRequest& getRequest(void);
   const HttpRequest& getRequest(void) const;
   Process& getProcess(void);
+  const Process& getProcess(void) const;
+  ProxyConnection& getProxy(void);
+  Compressor* getCompressor(void);
   std::string& getResponse(void);
   const std::string& getResponse(void) const;
   int& getStatus(void);
   const int& getStatus(void) const;
   std::string& getFullUri(void);
   const std::string& getFullUri(void) const;
+  const std::string& getStatusCode(void) const;
+  std::size_t getBytesSent(void) const;
+  uint64_t getRequestTime(void) const;
+  const uint64_t* getPhases(void) const;
+  std::string getUpstream(void) const;
 
   void setStatus(int status);
+  void setStatusCode(const std::string& code);
   void setSession(Session* session);
   void setProcess(Process& cgi_process);
+  void setProxy(const ProxyConnection& proxy);
+  void setCompressor(Compressor* compressor);
 
-  void setClientTimeout(std::time_t time = std::time(NULL));
-  void setSessionTimeout(void);
-  void setAllTimeout(std::time_t time = std::time(NULL));
-  void setTimer(std::time_t time = std::time(NULL));
+  void setClientTimeout(std::time_t time = Clock::now());
+  void setAllTimeout(std::time_t time = Clock::now());
+  void setTimer(std::time_t time = Clock::now());
   void handleTimeout(void);
 
-  void processEvent(const int event_type);
+  void processEvent(const struct kevent& event);
 
   /* request */
   void processRequest(void);
@@ -72,31 +84,51 @@ class Client {
   /* handler */
   void passErrorToHandler(int status);
   void passRequestToHandler(void);
-  void passToCgi(const int event_type);
+  void passToCgi(const struct kevent& event);
+  void resumeCgi(int status);
+  void passToProxy(const struct kevent& event);
+  void resumeFromCache(void);
 
   /* response */
   void writeData(void);
+  void setFileBody(const Response& response);
+  void sendFileBody(void);
+  void countBytesOut(std::size_t bytes);
 
+  void markPhase(int phase);
   void setToSend(bool set);
   bool isErrorCode(void);
   bool isCgiStarted(void);
   bool isCgiDone(void);
+  bool isProxyStarted(void);
+  bool isCacheable(void);
   void clear(void);
 
  private:
+  void logRequest(void);
+
   ServerManager* manager_;
   const int fd_;
-  Session* session_;
+  std::string session_id_;
   const TcpServer* tcp_server_;
   const SocketAddress address_;
   HttpServer* http_server_;
   Location location_;
   HttpRequest request_;
   Process cgi_process_;
+  ProxyConnection proxy_;
+  Compressor* compressor_;
   std::string fullUri_;
   std::string response_;
+  int file_fd_;
+  off_t file_offset_;
+  std::size_t file_remaining_;
   int status_;
+  std::string status_code_;
+  std::size_t bytes_sent_;
   std::time_t timeout_;
+  uint64_t phase_mark_;
+  uint64_t phases_[Metrics::PHASE_COUNT];
 
   bool is_response_ready_;
 };
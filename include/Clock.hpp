@@ -0,0 +1,34 @@
+#ifndef CLOCK_HPP_
+#define CLOCK_HPP_
+
+#include <stdint.h>
+
+#include <ctime>
+#include <string>
+
+/* clock of the event loop */
+class Clock {
+ public:
+  static void update(void);
+  static std::time_t now(void);
+  static const std::string& getHttpDate(void);
+  static std::string formatHttpDate(std::time_t time);
+  static const std::string& getLogDate(void);
+  static std::string formatLogDate(std::time_t time);
+  static uint64_t getMicroseconds(void);
+
+ private:
+  Clock(){};
+  ~Clock(){};
+
+  static const char* const DAYS[];
+  static const char* const MONTHS[];
+
+  static std::time_t now_;
+  static std::time_t date_time_;
+  static std::string date_;
+  static std::time_t log_date_time_;
+  static std::string log_date_;
+};
+
+#endif
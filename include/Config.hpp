@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "ServerBlock.hpp"
+#include "UpstreamBlock.hpp"
 
 class Config {
  public:
@@ -15,13 +16,23 @@ class Config {
   ~Config();
 
   const std::vector<ServerBlock>& getServerBlocks(void) const;
+  const std::vector<UpstreamBlock>& getUpstreamBlocks(void) const;
+  const std::map<std::string, std::string>& getTypes(void) const;
+  const std::map<std::string, std::string>& getLogFormats(void) const;
 
   void addServerBlock(const ServerBlock& server_block);
+  void addUpstreamBlock(const UpstreamBlock& upstream_block);
+  void addType(const std::string& type, const std::string& extension);
+  void addLogFormat(const std::string& name, const std::string& format);
 
  private:
   void validate(const ServerBlock& server_block) const;
+  void validate(const UpstreamBlock& upstream_block) const;
 
   std::vector<ServerBlock> server_blocks_;
+  std::vector<UpstreamBlock> upstream_blocks_;
+  std::map<std::string, std::string> types_;
+  std::map<std::string, std::string> log_formats_;
 };
 
 #endif
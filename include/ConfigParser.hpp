@@ -15,10 +15,19 @@ class ConfigParser {
   const Config& parse(void);
 
  private:
+  void parseInclude(void);
+  void parseTypes(void);
+  void loadDefaultTypes(void);
+  void parseLogFormat(void);
+
   void parseServerBlock(void);
   void parseListen(void);
   void parseServerName(void);
   void parseErrorPage(void);
+  void parseSessionShm(void);
+  void parseSessionSnapshot(void);
+  void parseAccessLog(void);
+  void parseSlowLog(void);
 
   void parseLocation(void);
   void parseClientMaxBodySize(void);
@@ -26,9 +35,23 @@ class ConfigParser {
   void parseReturn(void);
   void parseRoot(void);
   void parseAutoindex(void);
+  void parseGzipStatic(void);
+  void parseBrotliStatic(void);
+  void parseGzip(void);
+  void parseGzipTypes(void);
+  void parseGzipMinLength(void);
   void parseAuth(void);
   void parseIndex(void);
   void parseCgiParams(void);
+  void parseProxyPass(void);
+  void parseCacheTtl(void);
+  void parseCachePath(void);
+  void parseStubStatus(void);
+
+  void parseUpstreamBlock(void);
+  void parseUpstreamServer(void);
+  void parseBalance(void);
+  void parseHealthCheck(void);
 
   std::string expect(const std::string& expected = "");
   std::string peek(void);
@@ -36,6 +59,7 @@ class ConfigParser {
 
   Config config_;
   ServerBlock server_block_;
+  UpstreamBlock upstream_block_;
   Location location_block_;
   std::string content_;
   std::size_t pos_;
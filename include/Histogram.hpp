@@ -0,0 +1,34 @@
+#ifndef HISTOGRAM_HPP_
+#define HISTOGRAM_HPP_
+
+#include <stdint.h>
+
+#include <cstddef>
+
+/* log-bucketed histogram of durations in microseconds */
+class Histogram {
+ public:
+  Histogram();
+
+  void record(uint64_t value);
+
+  uint64_t count(void) const;
+  uint64_t sum(void) const;
+  uint64_t quantile(double q) const;
+
+ private:
+  static std::size_t indexOf(uint64_t value);
+  static uint64_t upperBound(std::size_t index);
+
+  static const std::size_t SUB_BITS = 4;
+  static const std::size_t SUB_COUNT = 1 << SUB_BITS;
+  static const std::size_t MAX_BIT = 39;
+  static const std::size_t BUCKET_COUNT =
+      SUB_COUNT + (MAX_BIT - SUB_BITS + 1) * SUB_COUNT;
+
+  uint64_t buckets_[BUCKET_COUNT];
+  uint64_t count_;
+  uint64_t sum_;
+};
+
+#endif
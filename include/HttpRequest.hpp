@@ -26,6 +26,7 @@ class HttpRequest {
   const std::string& getHost(void) const;
   std::size_t getContentLength(void) const;
   std::string getHeader(const std::string& key) const;
+  const headers_type& getHeaders(void) const;
   std::string getCookie(const std::string& name) const;
   const std::string& getBody(void) const;
   std::string& getBuffer(void);
@@ -46,6 +47,7 @@ class HttpRequest {
   bool hasCookie(void) const;
   bool isHeaderSet(void) const;
   bool isCompleted(void) const;
+  bool isStarted(void) const;
 
   void clear(void);
 
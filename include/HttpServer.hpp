@@ -4,20 +4,30 @@
 #include <map>
 #include <vector>
 
+#include "AccessLog.hpp"
+#include "CgiEnvironment.hpp"
 #include "ServerBlock.hpp"
 #include "Session.hpp"
+#include "SessionStore.hpp"
+#include "SlowLog.hpp"
 #include "constant.hpp"
 #include "exception.hpp"
 
+class CgiLimiter;
+class CgiWorkerPool;
+class Client;
+class UpstreamGroup;
+
 class HttpServer {
  public:
   typedef std::vector<Location> LocationType;
   typedef std::map<std::string, std::string> ErrorPageType;
-  typedef std::map<std::string, Session *> SessionType;
+  typedef std::map<std::string, CgiWorkerPool *> CgiPoolType;
+  typedef std::map<std::string, CgiLimiter *> CgiLimiterType;
+  typedef std::map<std::string, CgiEnvironment> CgiEnvType;
+  typedef std::map<std::string, UpstreamGroup *> UpstreamGroupType;
 
   HttpServer(const int id, const ServerBlock &server_block);
-  HttpServer(const HttpServer &origin);
-  HttpServer operator=(const HttpServer &origin);
   ~HttpServer();
 
   const Location &findLocation(const std::string &request_uri) const;
@@ -26,17 +36,39 @@ class HttpServer {
   int getServerKey(void) const;
   const std::string &getErrorPage(const std::string &code) const;
   Session *getSession(const std::string &id) const;
+  const SessionStore &getSessions(void) const;
+  CgiWorkerPool *getCgiPool(const std::string &location_uri) const;
+  CgiLimiter *getCgiLimiter(const std::string &location_uri) const;
+  const CgiEnvironment *getCgiEnvironment(
+      const std::string &location_uri) const;
+  UpstreamGroup *getUpstreamGroup(const std::string &location_uri) const;
 
   bool isExistSessionId(std::string &id);
-  void addSession(std::string &id, Session *session);
+  void addSession(Session *session, std::time_t now);
+  Session *touchSession(const std::string &id, std::time_t now);
   void destroySession(const std::string &id);
+  void expireSessions(std::time_t now);
+  void maintainCgiPools(std::time_t now);
+  void expireCgiQueues(std::time_t now);
+  void logAccess(const Client &client) const;
+  void logSlow(const Client &client);
+  void flushSlowLog(std::time_t now);
 
  private:
+  HttpServer(const HttpServer &origin);
+  HttpServer &operator=(const HttpServer &origin);
+
   const int server_id_;
   const LocationType locations_;
   const ErrorPageType error_pages_;
+  CgiPoolType cgi_pools_;
+  CgiLimiterType cgi_limiters_;
+  CgiEnvType cgi_envs_;
+  UpstreamGroupType upstream_groups_;
+  std::vector<AccessLog> access_logs_;
+  SlowLog slow_log_;
 
-  SessionType sessions_;
+  SessionStore *sessions_;
 };
 
 #endif
@@ -1,6 +1,7 @@
 #ifndef LOCATION_BLOCK_HPP_
 #define LOCATION_BLOCK_HPP_
 
+#include <ctime>
 #include <map>
 #include <set>
 #include <string>
@@ -13,6 +14,8 @@ class Location {
     AUTOINDEX,
     AUTH,
     INDEX,
+    GZIP_TYPES,
+    GZIP_MIN_LENGTH,
   };
 
   static const std::string DEFAULTS[];
@@ -32,10 +35,22 @@ class Location {
   const std::string& getReturnUrl(void) const;
   const std::string& getRoot(void) const;
   bool getAutoindex(void) const;
+  bool getGzipStatic(void) const;
+  bool getBrotliStatic(void) const;
+  bool getGzip(void) const;
+  std::size_t getGzipMinLength(void) const;
   bool getAuth(void) const;
   std::vector<std::string>& getIndex(void);
   const std::vector<std::string>& getIndex(void) const;
   std::string getCgiParam(const std::string& key) const;
+  std::size_t getCgiParam(const std::string& key, std::size_t value) const;
+  const std::string& getProxyHost(void) const;
+  const std::string& getProxyPort(void) const;
+  const std::string& getProxyUri(void) const;
+  std::time_t getCacheTtl(void) const;
+  const std::string& getCachePath(void) const;
+  const std::string& getHeaderBlock(void) const;
+  const std::string& getStubStatus(void) const;
 
   void setUri(const std::string& uri);
   void setBodyLimit(const std::string& raw);
@@ -43,12 +58,24 @@ class Location {
   void setReturnUrl(const std::string& return_url);
   void setRoot(const std::string& root);
   void setAutoindex(const std::string& raw);
+  void setGzipStatic(const std::string& raw);
+  void setBrotliStatic(const std::string& raw);
+  void setGzip(const std::string& raw);
+  void addGzipType(const std::string& type);
+  void setGzipMinLength(const std::string& raw);
   void setAuth(const std::string& raw);
   void addIndex(const std::string& index);
   void addCgiParam(const std::string& key, const std::string& value);
+  void setProxyPass(const std::string& url);
+  void setCacheTtl(const std::string& raw);
+  void setCachePath(const std::string& path);
+  void setStubStatus(const std::string& format);
 
   bool isAllowedMethod(const std::string& method) const;
-  bool isCgi(void);
+  bool isGzipType(const std::string& type) const;
+  bool isCgi(void) const;
+  bool isProxy(void) const;
+  void compileHeaderBlock(void);
   void clear(void);
 
  private:
@@ -58,10 +85,22 @@ class Location {
   std::string return_url_;
   std::string root_;
   bool autoindex_;
+  bool gzip_static_;
+  bool brotli_static_;
+  bool gzip_;
+  std::set<std::string> gzip_types_;
+  std::size_t gzip_min_length_;
   bool auth_;
   std::vector<std::string> index_;
   std::map<std::string, std::string> cgi_param_;
   bool is_cgi_;
+  std::string proxy_host_;
+  std::string proxy_port_;
+  std::string proxy_uri_;
+  std::time_t cache_ttl_;
+  std::string cache_path_;
+  std::string header_block_;
+  std::string stub_status_;
 };
 
 #endif
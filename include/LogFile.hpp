@@ -0,0 +1,39 @@
+#ifndef LOG_FILE_HPP_
+#define LOG_FILE_HPP_
+
+#include <sys/un.h>
+
+#include <map>
+#include <string>
+
+/* buffered log file or unix datagram socket, shared by path */
+class LogFile {
+ public:
+  void append(const std::string& line);
+  void flush(void);
+  void reopen(void);
+
+  static LogFile* open(const std::string& path);
+  static void flushAll(void);
+  static void reopenAll(void);
+
+ private:
+  explicit LogFile(const std::string& path);
+  ~LogFile();
+  LogFile(const LogFile& origin);
+  LogFile& operator=(const LogFile& origin);
+
+  int openFile(void) const;
+  int openSocket(void);
+  std::size_t capacity(void) const;
+
+  const std::string path_;
+  const bool is_socket_;
+  struct sockaddr_un address_;
+  int fd_;
+  std::string buffer_;
+
+  static std::map<std::string, LogFile*> files_;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef METRICS_HPP_
+#define METRICS_HPP_
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Histogram.hpp"
+
+/* counters of the event loop, bumped where things happen */
+class Metrics {
+ public:
+  enum Phase { PARSE, LOOKUP, HANDLE, GENERATE, DRAIN, PHASE_COUNT };
+  typedef std::map<std::string, std::size_t> StatusType;
+  typedef std::map<std::string, std::vector<Histogram> > LatencyType;
+
+  static const char* const PHASES[];
+
+  static void countLoop(std::size_t events);
+  static void countAccept(void);
+  static void countClose(void);
+  static void beginRead(void);
+  static void endRead(void);
+  static void beginRequest(void);
+  static void endRequest(void);
+  static void countStatus(const std::string& code);
+  static void countBytesIn(std::size_t size);
+  static void countBytesOut(std::size_t size);
+  static void recordLatency(const std::string& location,
+                            const uint64_t* phases);
+
+  static std::size_t getLoops(void);
+  static std::size_t getEvents(void);
+  static std::size_t getAccepted(void);
+  static std::size_t getActive(void);
+  static std::size_t getRequests(void);
+  static std::size_t getReading(void);
+  static std::size_t getWriting(void);
+  static std::size_t getBytesIn(void);
+  static std::size_t getBytesOut(void);
+  static const StatusType& getStatuses(void);
+  static const LatencyType& getLatencies(void);
+
+ private:
+  Metrics(){};
+  ~Metrics(){};
+
+  static std::size_t loops_;
+  static std::size_t events_;
+  static std::size_t accepted_;
+  static std::size_t closed_;
+  static std::size_t requests_;
+  static std::size_t reading_;
+  static std::size_t writing_;
+  static std::size_t bytes_in_;
+  static std::size_t bytes_out_;
+  static StatusType statuses_;
+  static LatencyType latencies_;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef MIME_TYPES_HPP_
+#define MIME_TYPES_HPP_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* media type of a file by its extension */
+class MimeTypes {
+ public:
+  static void define(const std::map<std::string, std::string>& types);
+  static const std::string& find(const std::string& path);
+
+ private:
+  typedef std::pair<std::string, std::string> Type;
+
+  MimeTypes(){};
+  ~MimeTypes(){};
+
+  static bool compare(const Type& type, const std::string& extension);
+
+  static std::vector<Type> types_;
+};
+
+#endif
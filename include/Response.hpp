@@ -1,12 +1,28 @@
 #ifndef RESPONSE_HPP_
 #define RESPONSE_HPP_
 
+#include <sys/types.h>
+
 #include <map>
 #include <string>
+#include <vector>
+
+#include "constant.hpp"
 
+/* a body kept in a file is sent after body, from file_offset */
 struct Response {
+  Response()
+      : is_streamed(false), file_fd(DEFAULT_FD), file_offset(0), file_size(0){};
+
   std::map<std::string, std::string> headers;
+  /* Set-Cookie values, each sent on its own line */
+  std::vector<std::string> cookies;
   std::string body;
+  bool is_streamed;
+
+  int file_fd;
+  off_t file_offset;
+  std::size_t file_size;
 };
 
 #endif
\ No newline at end of file
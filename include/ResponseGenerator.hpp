@@ -2,6 +2,7 @@
 #define RESPONSE_GENERATOR_HPP_
 
 #include "Client.hpp"
+#include "Clock.hpp"
 #include "FileOpenException.hpp"
 #include "HttpRequest.hpp"
 #include "Response.hpp"
@@ -23,8 +24,7 @@ class ResponseGenerator {
   static void generateGeneralHeader(std::string &response, Client &client);
   static void generateEntityHeader(std::string &response, Client &client,
                                    struct Response &response_dummy);
-  static std::string getConnectionHeader(Client &client);
-  static std::string getDateHeader(void);
+  static void appendConnectionHeader(std::string &response, Client &client);
 };
 
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 enum StatusIndex {
   C200,
@@ -17,6 +18,8 @@ enum StatusIndex {
   C413,
   C500,
   C501,
+  C502,
+  C503,
   C504,
   C505,
 };
@@ -24,6 +27,9 @@ enum StatusIndex {
 struct ResponseStatus {
   static const std::string CODES[];
   static const std::string REASONS[];
+  static const std::vector<std::string> LINES;
+
+  static std::vector<std::string> makeLines(void);
 };
 
 #endif
@@ -3,13 +3,21 @@
 
 #include "Listen.hpp"
 #include "Location.hpp"
+#include "constant.hpp"
 
 struct ServerBlock {
  public:
+  ServerBlock() : slow_log_threshold(SLOW_LOG_THRESHOLD){};
+
   std::vector<Listen> listens;
   std::set<std::string> server_names;
   std::map<std::string, std::string> error_pages;
   std::vector<Location> locations;
+  std::string session_path;
+  std::string snapshot_path;
+  std::map<std::string, std::string> access_logs;
+  std::string slow_log_path;
+  std::size_t slow_log_threshold;
 };
 
 #endif
@@ -8,16 +8,22 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <exception>
 #include <map>
 #include <string>
 
 #include "Client.hpp"
+#include "Clock.hpp"
 #include "Config.hpp"
+#include "MimeTypes.hpp"
 #include "TcpServer.hpp"
 
 class SocketAddress;
 class Client;
+class UpstreamGroup;
 
 class ServerManager {
  public:
@@ -26,14 +32,18 @@ class ServerManager {
 
   void setServer(void);
   void runServer(void);
+  void stopServer(void);
 
   void createEvent(uintptr_t ident, int16_t filter, uint16_t flags,
                    uint32_t fflags, intptr_t data, void *udata);
+  void watchProbe(int fd, UpstreamGroup *group);
+  void unwatchProbe(int fd);
 
  private:
   typedef std::map<std::string, TcpServer *> TcpServerType;
   typedef std::vector<HttpServer *> HttpServerType;
   typedef std::map<int, Client *> ClientType;
+  typedef std::map<int, UpstreamGroup *> ProbeType;
 
   void registerServer(const Config &config);
   TcpServer *getTcpServer(const std::string &key);
@@ -49,6 +59,9 @@ class ServerManager {
   void createListenEvent(int fd, TcpServer *server);
 
   void processEventOnQueue(const int events);
+  void processEventError(const struct kevent &event);
+  void notifyExit(const struct kevent &event);
+  void supervise(void);
   void acceptNewClient(const int server_socker, const TcpServer *tcp_server);
   void unconnectClient(const int client_fd);
 
@@ -59,6 +72,7 @@ class ServerManager {
   std::size_t number_of_servers_;
   ClientType clients_;
   std::set<int> listen_sockets_;
+  ProbeType probe_sockets_;
 
   std::vector<struct kevent> change_event_list;
   struct kevent event_list[CAPABLE_EVENT_SIZE];
@@ -4,6 +4,7 @@
 #include <ctime>
 #include <vector>
 
+#include "Clock.hpp"
 #include "constant.hpp"
 
 class Client;
@@ -18,11 +19,15 @@ class Session {
   Session operator=(const Session& origin);
   ~Session();
 
-  void setTimeout(std::time_t time = std::time(NULL));
+  void setTimeout(std::time_t time = Clock::now());
 
   const std::string& getID() const;
   std::time_t getTimeout() const;
   const std::string& getValue(std::string key) const;
+  const ValueType& getValues() const;
+
+  std::string encode(void) const;
+  static ValueType decode(const std::string& data);
 
  private:
   const std::string id_;
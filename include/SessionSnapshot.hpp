@@ -0,0 +1,43 @@
+#ifndef SESSION_SNAPSHOT_HPP_
+#define SESSION_SNAPSHOT_HPP_
+
+#include <ctime>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Session.hpp"
+
+/* append-only journal of the sessions of a virtual server */
+class SessionSnapshot {
+ public:
+  explicit SessionSnapshot(const std::string& path);
+  ~SessionSnapshot();
+
+  void load(std::vector<Session*>& sessions, std::time_t now);
+
+  void append(const Session& session);
+  void remove(const std::string& id);
+  void refresh(const Session& session);
+
+  void flush(void);
+  bool isBloated(std::size_t live) const;
+  void compact(const std::list<Session*>& sessions);
+
+ private:
+  SessionSnapshot(const SessionSnapshot& origin);
+  SessionSnapshot& operator=(const SessionSnapshot& origin);
+
+  void open(void);
+  static bool write(int fd, const std::string& data);
+  static std::string encode(const Session& session);
+
+  const std::string path_;
+  int fd_;
+  std::string pending_;
+  std::map<std::string, std::time_t> refreshed_;
+  std::size_t records_;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef SESSION_STORE_HPP_
+#define SESSION_STORE_HPP_
+
+#include <ctime>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "Session.hpp"
+#include "SessionSnapshot.hpp"
+#include "SharedSessions.hpp"
+
+/* sessions of a virtual server, optionally shared and journaled */
+class SessionStore {
+ public:
+  struct Stats {
+    Stats()
+        : lookups(0), hits(0), created(0), expired(0), evicted(0){};
+
+    std::size_t lookups;
+    std::size_t hits;
+    std::size_t created;
+    std::size_t expired;
+    std::size_t evicted;
+  };
+
+  explicit SessionStore(const std::string& shared_path = "",
+                        const std::string& snapshot_path = "");
+  ~SessionStore();
+
+  Session* find(const std::string& id, std::time_t now);
+  Session* touch(const std::string& id, std::time_t now);
+  void insert(Session* session, std::time_t now);
+  void erase(const std::string& id);
+  void sweep(std::time_t now);
+
+  std::size_t size(void) const;
+  std::size_t capacity(void) const;
+  const Stats& getStats(void) const;
+
+ private:
+  enum SlotState { EMPTY = 0, USED, DELETED };
+
+  struct Slot {
+    Slot() : state(EMPTY), session(NULL){};
+
+    int state;
+    Session* session;
+    std::list<Session*>::iterator lru;
+  };
+
+  SessionStore(const SessionStore& origin);
+  SessionStore& operator=(const SessionStore& origin);
+
+  void restore(void);
+  void keep(Session* session, std::time_t now);
+  std::size_t locate(const std::string& id) const;
+  std::size_t locateAlive(const std::string& id, std::time_t now);
+  void place(Session* session, std::list<Session*>::iterator lru);
+  void remove(std::size_t index);
+  void rebuild(void);
+
+  std::vector<Slot> slots_;
+  std::list<Session*> lru_;
+  std::size_t used_;
+  std::size_t deleted_;
+  Stats stats_;
+  SharedSessions* shared_;
+  SessionSnapshot* snapshot_;
+};
+
+#endif
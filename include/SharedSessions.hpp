@@ -0,0 +1,73 @@
+#ifndef SHARED_SESSIONS_HPP_
+#define SHARED_SESSIONS_HPP_
+
+#include <stdint.h>
+
+#include <ctime>
+#include <string>
+
+#include "Session.hpp"
+
+/* sessions shared by every webserv process using the same file */
+class SharedSessions {
+ public:
+  explicit SharedSessions(const std::string& path);
+  ~SharedSessions();
+
+  bool store(const Session& session, std::time_t now);
+  bool load(const std::string& id, std::time_t now,
+            Session::ValueType& values);
+  void erase(const std::string& id);
+  void sweep(std::time_t now);
+
+  static bool fits(const Session& session);
+
+ private:
+  enum SlotState { EMPTY = 0, USED, DELETED };
+
+  struct Header {
+    char magic[8];
+    uint32_t slots;
+    uint32_t shards;
+    uint32_t id_size;
+    uint32_t data_size;
+    char padding[40];
+  };
+
+  /* one lock per cache line */
+  struct Lock {
+    volatile int value;
+    char padding[60];
+  };
+
+  struct Slot {
+    int64_t expires;
+    uint32_t data_length;
+    uint8_t state;
+    char id[SESSION_SHM_ID_SIZE];
+    char data[SESSION_SHM_DATA_SIZE];
+  };
+
+  SharedSessions(const SharedSessions& origin);
+  SharedSessions& operator=(const SharedSessions& origin);
+
+  void map(void);
+  void reset(void);
+
+  Slot* locate(const std::string& id, uint64_t id_hash, std::time_t now,
+               bool for_insert);
+  void lock(std::size_t shard);
+  void unlock(std::size_t shard);
+
+  static const char MAGIC[];
+  static const std::size_t LENGTH;
+
+  const std::string path_;
+  int fd_;
+  Header* header_;
+  Lock* locks_;
+  Slot* slots_;
+  std::size_t next_shard_;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef SLOW_LOG_HPP_
+#define SLOW_LOG_HPP_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <ctime>
+#include <list>
+#include <string>
+
+#include "LogFile.hpp"
+
+class Client;
+
+/* slow log of a virtual server, with the time of each phase */
+class SlowLog {
+ public:
+  SlowLog();
+  SlowLog(const std::string& path, std::size_t threshold);
+  SlowLog(const SlowLog& origin);
+  SlowLog& operator=(const SlowLog& origin);
+  ~SlowLog();
+
+  void write(const Client& client);
+  void flush(std::time_t now);
+
+ private:
+  struct Pending {
+    pid_t pid;
+    std::time_t since;
+    std::string line;
+  };
+
+  std::string render(const Client& client) const;
+  static std::string describeExit(int status);
+
+  LogFile* file_;
+  uint64_t threshold_;
+  std::list<Pending> pending_;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef UPSTREAM_BLOCK_HPP_
+#define UPSTREAM_BLOCK_HPP_
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "setting.hpp"
+
+enum Balance { B_ROUND_ROBIN = 0, B_LEAST_CONN, B_HASH_URI, B_HASH_SESSION };
+
+struct UpstreamServer {
+  UpstreamServer();
+  explicit UpstreamServer(const std::string& token);
+
+  void setOption(const std::string& token);
+
+  std::string host;
+  std::string port;
+  std::size_t weight;
+  std::size_t max_fails;
+  std::time_t fail_timeout;
+};
+
+/* a check_interval of 0 disables the active health check */
+struct UpstreamBlock {
+  UpstreamBlock();
+
+  void setBalance(const std::vector<std::string>& tokens);
+  void setHealthCheck(const std::vector<std::string>& tokens);
+
+  std::string name;
+  std::vector<UpstreamServer> servers;
+  int balance;
+  std::time_t check_interval;
+  std::string check_uri;
+};
+
+#endif
@@ -24,7 +24,12 @@ const int DEFAULT_FD = -1;
 const int METHODS_COUNT = 8;
 const std::size_t NPOS = -1;
 
+const std::string ACCESS_LOG_JSON = "json";
+const std::string ACCESS_LOG_BINARY = "binary";
+const std::string ACCESS_LOG_SOCKET_PREFIX = "unix:";
+
 const std::string BASE10 = "0123456789";
+const std::string BASE16 = "0123456789abcdefABCDEF";
 const std::string CRLF = "\r\n";
 const std::string DOUBLE_CRLF = "\r\n\r\n";
 const std::string LF = "\n";
@@ -2,9 +2,24 @@
 #define HANDLER_HPP_
 
 #include "AutoIndexHandler.hpp"
+#include "CgiEnvironment.hpp"
 #include "CgiHandler.hpp"
+#include "CgiLimiter.hpp"
+#include "CgiWorker.hpp"
+#include "CgiWorkerPool.hpp"
+#include "Compressor.hpp"
+#include "DiskCache.hpp"
 #include "Process.hpp"
+#include "ProcessTable.hpp"
+#include "ProxyConnection.hpp"
+#include "ProxyHandler.hpp"
+#include "ResponseCache.hpp"
+#include "ResponseStream.hpp"
 #include "SessionHandler.hpp"
+#include "Spawner.hpp"
 #include "StaticContentHandler.hpp"
+#include "StatusHandler.hpp"
+#include "UpstreamGroup.hpp"
+#include "UpstreamPool.hpp"
 
 #endif
\ No newline at end of file
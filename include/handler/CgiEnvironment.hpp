@@ -0,0 +1,31 @@
+#ifndef CGI_ENVIRONMENT_HPP_
+#define CGI_ENVIRONMENT_HPP_
+
+#include <string>
+#include <vector>
+
+#include "Location.hpp"
+
+/* environment of a CGI location. variables that do not depend on the
+request are serialized once at config load, a request only appends its own */
+class CgiEnvironment {
+ public:
+  typedef std::vector<std::string> EntryType;
+
+  CgiEnvironment(const int server_key, const Location& location);
+  CgiEnvironment(const CgiEnvironment& origin);
+  CgiEnvironment& operator=(const CgiEnvironment& origin);
+  ~CgiEnvironment();
+
+  static const std::string& getWorkingDirectory(void);
+  static void add(EntryType& entries, const std::string& key,
+                  const std::string& value);
+  static char** toEnvp(EntryType& entries, std::vector<char*>& envp);
+
+  const EntryType& getTemplate(void) const;
+
+ private:
+  EntryType template_;
+};
+
+#endif
@@ -2,39 +2,70 @@
 #define CGI_HANDLER_HPP_
 
 #include <signal.h>
+#include <sys/wait.h>
 
 #include <cstdlib>
 
+#include "CgiEnvironment.hpp"
+#include "CgiLimiter.hpp"
+#include "CgiWorkerPool.hpp"
 #include "Client.hpp"
+#include "Process.hpp"
+#include "ProcessTable.hpp"
+#include "ResponseStream.hpp"
+#include "Spawner.hpp"
 
 enum PipeFD { READ = 0, WRITE = 1 };
-enum Phase { P_UNSTARTED = 0, P_WRITE, P_WAIT, P_READ, P_DONE, P_RESET };
+enum Phase {
+  P_UNSTARTED = 0,
+  P_QUEUED,
+  P_WRITE,
+  P_READ,
+  P_EXIT,
+  P_DONE,
+  P_RESET
+};
 
 class CgiHandler {
  public:
   static void execute(Client *client);
-  static void handle(Client *client, int event_type);
+  static void handle(Client *client, const struct kevent &event);
   static struct Response getResponse(Client *client);
 
+  static void drain(Client *client);
   static void setPhase(Client *client, int phase);
 
  private:
   CgiHandler(){};
   ~CgiHandler(){};
 
+  static void run(Client *client);
+  static void dispatch(Client *client, CgiWorkerPool *pool,
+                       CgiWorker *worker);
+  static void start(Client *client);
+
   static void sendToCgi(Client *client);
   static void readFromCgi(Client *client);
+  static void unframe(Client *client, const char *data, std::size_t size);
+  static void deliver(Client *client, const char *data, std::size_t size);
+
+  static void sendHeader(Client *client, std::size_t boundary,
+                         std::size_t separator_size);
+  static void finish(Client *client);
+  static bool hasExited(Client *client);
 
   static std::map<std::string, std::string> generateHeader(
       const std::string &headers);
 
   static void setTimer(Client *client);
 
-  static char **generateEnvp(const Client *client);
+  static CgiEnvironment::EntryType generateEnv(const Client *client);
+  static std::string generateFrame(const Client *client);
 
-  static void deleteEnvp(char **envp);
   static std::string getAbsolutePath(const std::string &uri);
+  static void closeOutput(Client *client);
   static void cleanUp(Client *client);
+  static void releaseSlot(Client *client);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef CGI_LIMITER_HPP_
+#define CGI_LIMITER_HPP_
+
+#include <ctime>
+#include <deque>
+#include <list>
+
+#include "Clock.hpp"
+#include "Location.hpp"
+
+class Client;
+
+/* limit on concurrent CGI requests of one location */
+class CgiLimiter {
+ public:
+  explicit CgiLimiter(const Location& location);
+  ~CgiLimiter();
+
+  bool acquire(void);
+  void release(void);
+  void enqueue(Client* client, std::time_t now = Clock::now());
+  void cancel(Client* client);
+  void expire(std::time_t now = Clock::now());
+
+  std::size_t running(void) const;
+  std::size_t queued(void) const;
+  std::size_t peakQueued(void) const;
+  std::size_t rejected(void) const;
+  std::size_t expired(void) const;
+
+  static std::size_t runningTotal(void);
+  static std::size_t queuedTotal(void);
+
+ private:
+  struct Waiter {
+    Client* client;
+    std::time_t since;
+  };
+  typedef std::deque<Waiter> QueueType;
+
+  CgiLimiter(const CgiLimiter& origin);
+  CgiLimiter& operator=(const CgiLimiter& origin);
+
+  bool hasSlot(void) const;
+  static void wakeUp(void);
+
+  const std::size_t max_processes_;
+  const std::size_t queue_size_;
+  const std::time_t queue_timeout_;
+
+  std::size_t running_;
+  QueueType queue_;
+
+  std::size_t peak_queued_;
+  std::size_t rejected_;
+  std::size_t expired_;
+
+  static std::size_t running_total_;
+  static std::list<CgiLimiter*> limiters_;
+};
+
+#endif
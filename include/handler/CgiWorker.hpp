@@ -0,0 +1,26 @@
+#ifndef CGI_WORKER_HPP_
+#define CGI_WORKER_HPP_
+
+#include <ctime>
+
+#include "Clock.hpp"
+
+struct CgiWorker {
+  CgiWorker()
+      : pid(-1),
+        input_fd(-1),
+        output_fd(-1),
+        served(0),
+        last_used(Clock::now()),
+        is_busy(false){};
+
+  int pid;
+  int input_fd;
+  int output_fd;
+
+  std::size_t served;
+  std::time_t last_used;
+  bool is_busy;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef CGI_WORKER_POOL_HPP_
+#define CGI_WORKER_POOL_HPP_
+
+#include <ctime>
+#include <list>
+#include <string>
+
+#include "CgiWorker.hpp"
+#include "Clock.hpp"
+#include "Location.hpp"
+
+/* pool of persistent CGI workers for one location, both directions
+framed as "<decimal length>\n<payload>" */
+class CgiWorkerPool {
+ public:
+  explicit CgiWorkerPool(const Location& location);
+  ~CgiWorkerPool();
+
+  CgiWorker* acquire(std::time_t now = Clock::now());
+  void release(CgiWorker* worker, std::time_t now = Clock::now());
+  void retire(CgiWorker* worker);
+  void maintain(std::time_t now = Clock::now());
+
+  std::size_t size(void) const;
+  std::size_t idle(void) const;
+
+ private:
+  typedef std::list<CgiWorker*> WorkerType;
+
+  CgiWorkerPool(const CgiWorkerPool& origin);
+  CgiWorkerPool& operator=(const CgiWorkerPool& origin);
+
+  CgiWorker* spawn(void);
+  bool isAlive(const CgiWorker* worker) const;
+
+  const std::string cgi_path_;
+  const std::string worker_path_;
+  const std::size_t min_workers_;
+  const std::size_t max_workers_;
+  const std::time_t idle_timeout_;
+  const std::size_t max_requests_;
+
+  WorkerType workers_;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef COMPRESSOR_HPP_
+#define COMPRESSOR_HPP_
+
+#include <zlib.h>
+
+#include <ctime>
+#include <list>
+#include <map>
+#include <string>
+
+#include "Response.hpp"
+
+class Client;
+
+/* gzip and deflate content coding of responses */
+class Compressor {
+ public:
+  enum Coding { IDENTITY = 0, GZIP, DEFLATE };
+
+  struct Stats {
+    Stats() : encoded(0), bytes_in(0), bytes_out(0), hits(0), misses(0){};
+
+    std::size_t encoded;
+    std::size_t bytes_in;
+    std::size_t bytes_out;
+    std::size_t hits;
+    std::size_t misses;
+  };
+
+  Compressor();
+  ~Compressor();
+
+  static void encode(Client* client, Response& response);
+  static bool encodeFile(Client* client, Response& response,
+                         const std::string& path);
+  static Compressor* begin(Client* client, Response& response);
+
+  void update(const char* data, std::size_t size, std::string& out);
+  void finish(std::string& out);
+
+  static std::size_t size(void);
+  static const Stats& getStats(void);
+
+ private:
+  struct Entry {
+    off_t file_size;
+    std::time_t mtime;
+    std::string body;
+    std::list<std::string>::iterator lru;
+  };
+
+  Compressor(const Compressor& origin);
+  Compressor& operator=(const Compressor& origin);
+
+  static int negotiate(Client* client, Response& response);
+  static void setHeader(Response& response, int coding);
+  static std::string getType(const Response& response);
+  static void deflateBody(const std::string& body, int coding,
+                          std::string& out);
+  static void store(const std::string& key, const Entry& entry);
+  static void evict(void);
+
+  void start(int coding);
+  void deflateData(const char* data, std::size_t size, int flush,
+                   std::string& out);
+
+  static const std::string CODINGS[];
+
+  static std::map<std::string, Entry> entries_;
+  static std::list<std::string> lru_;
+  static std::size_t size_;
+  static Stats stats_;
+
+  z_stream stream_;
+  bool is_started_;
+};
+
+#endif
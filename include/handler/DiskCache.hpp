@@ -0,0 +1,92 @@
+#ifndef DISK_CACHE_HPP_
+#define DISK_CACHE_HPP_
+
+#include <stdint.h>
+
+#include <ctime>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Clock.hpp"
+#include "Response.hpp"
+
+/* cached responses kept in a directory across restarts */
+class DiskCache {
+ public:
+  struct Stats {
+    Stats() : hits(0), misses(0), stores(0), evictions(0){};
+
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t stores;
+    std::size_t evictions;
+  };
+
+  explicit DiskCache(const std::string& path);
+  ~DiskCache();
+
+  bool lookup(const std::string& key, Response& response,
+              std::time_t now = Clock::now());
+  void store(const std::string& key, const Response& response,
+             std::time_t ttl, std::time_t now = Clock::now());
+  void sweep(std::time_t now = Clock::now());
+
+  std::size_t size(void) const;
+  const Stats& getStats(void) const;
+
+  static void open(const std::string& path);
+  static DiskCache* find(const std::string& path);
+  static void sweepAll(std::time_t now = Clock::now());
+  static const std::map<std::string, DiskCache*>& getCaches(void);
+
+ private:
+  enum SlotState { S_EMPTY = 0, S_USED, S_DELETED };
+
+  struct Header {
+    char magic[8];
+    uint32_t slots;
+    uint32_t key_size;
+    uint64_t size;
+  };
+  struct Slot {
+    uint64_t hash;
+    uint64_t size;
+    int64_t expires;
+    int64_t stored_at;
+    int64_t used_at;
+    uint32_t header_size;
+    uint32_t state;
+    char key[DISK_CACHE_KEY_SIZE];
+  };
+
+  DiskCache(const DiskCache& origin);
+  DiskCache& operator=(const DiskCache& origin);
+
+  void map(void);
+  void reset(void);
+  void order(void);
+  std::size_t findSlot(const std::string& key, uint64_t hash) const;
+  std::size_t findFreeSlot(uint64_t hash) const;
+  void erase(std::size_t index);
+  void evict(void);
+  bool writeFile(const std::string& path, const std::string& data) const;
+  std::string getFilePath(std::size_t index) const;
+
+  static std::string serialize(const Response& response);
+
+  const std::string path_;
+  int index_fd_;
+  Header* header_;
+  Slot* slots_;
+  std::size_t sweep_cursor_;
+  std::list<std::size_t> lru_;
+  std::vector<std::list<std::size_t>::iterator> positions_;
+  Stats stats_;
+
+  static const char MAGIC[8];
+  static std::map<std::string, DiskCache*> caches_;
+};
+
+#endif
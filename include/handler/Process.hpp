@@ -3,8 +3,23 @@
 
 #include <string>
 
+#include "ResponseStream.hpp"
+#include "constant.hpp"
+
+class CgiLimiter;
+struct CgiWorker;
+class CgiWorkerPool;
+
 struct Process {
-  Process() : phase(0){};
+  Process()
+      : phase(0),
+        pid(0),
+        input_fd(DEFAULT_FD),
+        output_fd(DEFAULT_FD),
+        limiter(NULL),
+        pool(NULL),
+        worker(NULL),
+        frame_remaining(NPOS){};
 
   int phase;
 
@@ -12,8 +27,16 @@ struct Process {
   int input_fd;
   int output_fd;
 
+  CgiLimiter* limiter;
+  CgiWorkerPool* pool;
+  CgiWorker* worker;
+
   std::string message_to_send;
   std::string message_received;
+
+  std::size_t frame_remaining;
+  std::string frame_header;
+  Stream stream;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef PROCESS_TABLE_HPP_
+#define PROCESS_TABLE_HPP_
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#include <deque>
+#include <map>
+#include <string>
+
+/* every child the server spawns, until it is reaped */
+class ProcessTable {
+ public:
+  struct Stats {
+    Stats()
+        : runs(0),
+          failures(0),
+          last_status(0),
+          user_time(0),
+          system_time(0),
+          wall_time(0),
+          max_wall_time(0){};
+
+    std::size_t runs;
+    std::size_t failures;
+    int last_status;
+    double user_time;
+    double system_time;
+    double wall_time;
+    double max_wall_time;
+  };
+  typedef std::map<std::string, Stats> StatsType;
+
+  static void add(pid_t pid, const std::string& script);
+  static void reap(void);
+  static bool isRunning(pid_t pid);
+  static bool findExit(pid_t pid, int& status);
+  static std::size_t size(void);
+  static const StatsType& getStats(void);
+
+ private:
+  struct Entry {
+    std::string script;
+    struct timeval started;
+  };
+  typedef std::map<pid_t, Entry> EntryType;
+
+  ProcessTable(){};
+  ~ProcessTable(){};
+
+  static void record(pid_t pid, int status, const struct rusage& usage);
+  static void remember(pid_t pid, int status);
+  static double toSeconds(const struct timeval& time);
+
+  static EntryType entries_;
+  static StatsType stats_;
+  static std::map<pid_t, int> exits_;
+  static std::deque<pid_t> exit_order_;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef PROXY_CONNECTION_HPP_
+#define PROXY_CONNECTION_HPP_
+
+#include <string>
+
+#include "ResponseStream.hpp"
+#include "constant.hpp"
+
+class UpstreamGroup;
+class UpstreamPool;
+
+enum ChunkState { CHUNK_SIZE = 0, CHUNK_DATA, CHUNK_DATA_END, CHUNK_TRAILER };
+
+struct ProxyConnection {
+  ProxyConnection()
+      : phase(0),
+        fd(DEFAULT_FD),
+        group(NULL),
+        pool(NULL),
+        tries(0),
+        is_reused(false),
+        is_reusable(true),
+        sent(0),
+        body_remaining(NPOS),
+        is_chunked(false),
+        chunk_state(CHUNK_SIZE),
+        chunk_remaining(0){};
+
+  int phase;
+
+  int fd;
+  UpstreamGroup* group;
+  UpstreamPool* pool;
+  std::size_t tries;
+  bool is_reused;
+  bool is_reusable;
+
+  std::string message_to_send;
+  std::size_t sent;
+  std::string message_received;
+
+  /* framing of the upstream body, NPOS remaining means until EOF */
+  std::size_t body_remaining;
+  bool is_chunked;
+  int chunk_state;
+  std::size_t chunk_remaining;
+
+  Stream stream;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef PROXY_HANDLER_HPP_
+#define PROXY_HANDLER_HPP_
+
+#include <sys/socket.h>
+
+#include "Client.hpp"
+#include "ProxyConnection.hpp"
+#include "ResponseStream.hpp"
+#include "UpstreamGroup.hpp"
+#include "UpstreamPool.hpp"
+
+class ProxyHandler {
+ public:
+  static void execute(Client *client);
+  static void handle(Client *client, const struct kevent &event);
+  static void drain(Client *client);
+
+  static void setPhase(Client *client, int phase);
+
+ private:
+  static const std::string HOP_BY_HOP[];
+
+  ProxyHandler(){};
+  ~ProxyHandler(){};
+
+  static void connect(Client *client);
+  static void retry(Client *client);
+
+  static void sendToUpstream(Client *client);
+  static void readFromUpstream(Client *client);
+
+  static void parseHeader(Client *client);
+  static void parseBody(Client *client, const char *data, std::size_t size);
+  static void decodeChunk(Client *client, const char *data, std::size_t size);
+  static void finish(Client *client);
+
+  static std::string generateRequest(const Client *client);
+  static std::string generatePath(const Client *client);
+  static Response generateResponse(Client *client, const std::string &header,
+                                   bool &has_body);
+  static std::string rewriteLocation(const Client *client,
+                                     const std::string &location);
+
+  static void setTimer(Client *client);
+
+  static bool isIdempotent(const std::string &method);
+  static bool isHopByHop(const std::string &name);
+  static std::string canonicalize(const std::string &name);
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef RESPONSE_CACHE_HPP_
+#define RESPONSE_CACHE_HPP_
+
+#include <ctime>
+#include <list>
+#include <map>
+#include <string>
+
+#include "Clock.hpp"
+#include "Response.hpp"
+
+class Client;
+
+enum CacheResult { CACHE_HIT = 0, CACHE_MISS, CACHE_WAIT, CACHE_PASS };
+
+/* microcache of CGI and proxied responses */
+class ResponseCache {
+ public:
+  struct Stats {
+    Stats()
+        : hits(0),
+          misses(0),
+          coalesced(0),
+          passes(0),
+          stores(0),
+          evictions(0){};
+
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t coalesced;
+    std::size_t passes;
+    std::size_t stores;
+    std::size_t evictions;
+  };
+
+  static int lookup(Client* client, Response& response,
+                    std::time_t now = Clock::now());
+  static bool begin(Client* client, const Response& response,
+                    std::time_t now = Clock::now());
+  static bool append(Client* client, const char* data, std::size_t size);
+  static void commit(Client* client, std::time_t now = Clock::now());
+  static void cancel(Client* client);
+  static void expire(std::time_t now = Clock::now());
+
+  static bool isFilling(Client* client);
+  static std::size_t size(void);
+  static std::size_t entries(void);
+  static const Stats& getStats(void);
+
+ private:
+  struct Entry {
+    Response response;
+    std::time_t stored_at;
+    std::time_t expires;
+    bool is_pass;
+    std::list<std::string>::iterator lru;
+  };
+  struct Fill {
+    Client* owner;
+    std::list<Client*> waiters;
+    std::time_t since;
+    Response response;
+    std::time_t ttl;
+  };
+  typedef std::map<std::string, Entry> EntryType;
+  typedef std::map<std::string, Fill> FillType;
+
+  ResponseCache(){};
+  ~ResponseCache(){};
+
+  static std::string generateKey(const Client* client);
+  static std::time_t getTtl(const Client* client, const Response& response,
+                            std::time_t now);
+  static void store(const std::string& key, const Response& response,
+                    std::time_t ttl, bool is_pass, std::time_t now);
+  static void remove(EntryType::iterator entry);
+  static void release(const std::string& key);
+  static std::size_t sizeOf(const Response& response);
+
+  static EntryType entries_;
+  static std::list<std::string> lru_;
+  static FillType fills_;
+  static std::map<Client*, std::string> clients_;
+  static std::size_t size_;
+  static Stats stats_;
+};
+
+#endif
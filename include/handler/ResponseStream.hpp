@@ -0,0 +1,47 @@
+#ifndef RESPONSE_STREAM_HPP_
+#define RESPONSE_STREAM_HPP_
+
+#include <map>
+#include <string>
+
+#include "Response.hpp"
+
+class Client;
+
+/* progress of a response sent while its source (a CGI script or a
+proxied server) is still producing it */
+struct Stream {
+  Stream()
+      : is_header_sent(false),
+        is_chunked(false),
+        is_paused(false),
+        is_captured(false),
+        is_encoded(false){};
+
+  bool is_header_sent;
+  bool is_chunked;
+  bool is_paused;
+  bool is_captured;
+  bool is_encoded;
+};
+
+/* forwarding of a streamed response to the client */
+class ResponseStream {
+ public:
+  static void sendHeader(Client *client, Stream &stream, Response &response,
+                         bool has_body = true);
+  static void append(Client *client, Stream &stream, int source_fd,
+                     const char *data, std::size_t size);
+  static void pause(Client *client, Stream &stream, int source_fd);
+  static void drain(Client *client, Stream &stream, int source_fd);
+  static void end(Client *client, Stream &stream);
+
+  static bool hasHeader(const std::map<std::string, std::string> &headers,
+                        const std::string &name);
+
+ private:
+  ResponseStream(){};
+  ~ResponseStream(){};
+};
+
+#endif
@@ -11,8 +11,14 @@ class SessionHandler {
  private:
   static std::string getNewSessionId(HttpServer *server);
   static std::string createSessionId(void);
+  static void fillEntropy(void);
   static void createSession(Client *client, std::string &id);
   static Session::ValueType parseData(const std::string &data);
+
+  static const char BASE64URL[];
+  static unsigned char entropy_[SESSION_ID_BATCH_SIZE];
+  static std::size_t entropy_pos_;
+
   SessionHandler(){};
   ~SessionHandler(){};
 };
@@ -0,0 +1,17 @@
+#ifndef SPAWNER_HPP_
+#define SPAWNER_HPP_
+
+#include <sys/types.h>
+
+/* process creation for CGI without duplicating the server's address space.
+every descriptor the server opens is close-on-exec, so a child only keeps
+the pipes bound to its stdin and stdout. children are tracked in the
+ProcessTable until reaped */
+struct Spawner {
+  static int openPipe(int pipe_fds[2]);
+  static int setCloseOnExec(int fd);
+  static pid_t spawn(char* const argv[], char* const envp[], int stdin_fd,
+                     int stdout_fd);
+};
+
+#endif
@@ -1,9 +1,12 @@
 #ifndef STATIC_CONTENT_HANDLER_HPP_
 #define STATIC_CONTENT_HANDLER_HPP_
 
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "Client.hpp"
+#include "MimeTypes.hpp"
 
 class HttpServer;
 class Client;
@@ -17,6 +20,10 @@ class StaticContentHandler {
   StaticContentHandler(){};
   ~StaticContentHandler(){};
 
+  static bool openPrecompressed(Client *client, struct Response &response);
+  static bool encodeFile(Client *client, struct Response &response);
+  static bool openSibling(const std::string &path, struct Response &response);
+  static std::string findFile(Location &location, const std::string &uri);
   static std::string generateBody(Client *client);
   static std::string readIndexFile(Location &location, const std::string &url);
   static std::string readPage(Location &location, const std::string &uri);
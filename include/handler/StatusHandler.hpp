@@ -0,0 +1,36 @@
+#ifndef STATUS_HANDLER_HPP_
+#define STATUS_HANDLER_HPP_
+
+#include "Client.hpp"
+
+/* status page of a stub_status location */
+class StatusHandler {
+ public:
+  static struct Response handle(Client *client);
+
+ private:
+  StatusHandler(){};
+  ~StatusHandler(){};
+
+  static std::string renderText(Client *client);
+  static std::string renderPrometheus(Client *client);
+  static void appendFamily(std::string &body, const std::string &name,
+                           const std::string &type, const std::string &help);
+  static void appendSample(std::string &body, const std::string &name,
+                           const std::string &labels, std::size_t value);
+  static void appendSample(std::string &body, const std::string &name,
+                           const std::string &labels,
+                           const std::string &value);
+  static void appendLatencies(std::string &body);
+  static std::string toLabel(const std::string &name,
+                             const std::string &value);
+  static std::size_t getWaiting(void);
+  static std::string getRatio(std::size_t part, std::size_t whole);
+  static std::string toSeconds(uint64_t microseconds);
+
+  static const std::size_t QUANTILE_COUNT = 3;
+  static const double QUANTILES[];
+  static const char *const QUANTILE_LABELS[];
+};
+
+#endif
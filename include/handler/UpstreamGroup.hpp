@@ -0,0 +1,83 @@
+#ifndef UPSTREAM_GROUP_HPP_
+#define UPSTREAM_GROUP_HPP_
+
+#include <sys/event.h>
+
+#include <ctime>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Clock.hpp"
+#include "UpstreamBlock.hpp"
+#include "UpstreamPool.hpp"
+
+class Client;
+class ServerManager;
+
+/* servers a proxied location balances its requests over */
+class UpstreamGroup {
+ public:
+  explicit UpstreamGroup(const UpstreamBlock& block);
+  ~UpstreamGroup();
+
+  UpstreamPool* select(const Client* client, std::time_t now = Clock::now());
+  void fail(UpstreamPool* pool, std::time_t now = Clock::now());
+  void succeed(UpstreamPool* pool);
+  void maintain(ServerManager* manager, std::time_t now = Clock::now());
+  void handleProbe(ServerManager* manager, const struct kevent& event);
+
+  const std::string& getName(void) const;
+  std::size_t size(void) const;
+  std::size_t available(std::time_t now = Clock::now()) const;
+
+  static void define(const UpstreamBlock& block);
+  static UpstreamGroup* find(const std::string& host, const std::string& port);
+  static void maintainAll(ServerManager* manager,
+                          std::time_t now = Clock::now());
+  static const std::map<std::string, UpstreamGroup*>& getGroups(void);
+
+ private:
+  struct Peer {
+    UpstreamPool* pool;
+    std::size_t weight;
+    std::size_t max_fails;
+    std::time_t fail_timeout;
+
+    long current_weight;
+    std::size_t fails;
+    std::time_t failed_at;
+
+    bool is_healthy;
+    int probe_fd;
+    std::time_t probed_at;
+  };
+  typedef std::vector<std::pair<uint64_t, std::size_t> > RingType;
+
+  UpstreamGroup(const UpstreamGroup& origin);
+  UpstreamGroup& operator=(const UpstreamGroup& origin);
+
+  Peer* selectRoundRobin(std::time_t now);
+  Peer* selectLeastConn(std::time_t now);
+  Peer* selectHash(const std::string& key, std::time_t now);
+  Peer* findPeer(const UpstreamPool* pool);
+  Peer* findPeer(int probe_fd);
+  bool isAvailable(const Peer& peer, std::time_t now) const;
+
+  void startProbe(ServerManager* manager, Peer& peer, std::time_t now);
+  void endProbe(ServerManager* manager, Peer& peer, bool is_healthy);
+
+  const std::string name_;
+  const int balance_;
+  const std::time_t check_interval_;
+  const std::string check_uri_;
+
+  std::vector<Peer> peers_;
+  RingType ring_;
+  std::size_t next_;
+
+  static std::map<std::string, UpstreamGroup*> groups_;
+};
+
+#endif
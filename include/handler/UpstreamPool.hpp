@@ -0,0 +1,50 @@
+#ifndef UPSTREAM_POOL_HPP_
+#define UPSTREAM_POOL_HPP_
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <ctime>
+#include <list>
+#include <string>
+
+#include "Clock.hpp"
+
+/* keep-alive connections to one upstream server */
+class UpstreamPool {
+ public:
+  UpstreamPool(const std::string& host, const std::string& port);
+  ~UpstreamPool();
+
+  int acquire(bool& is_reused);
+  void release(int fd, std::time_t now = Clock::now());
+  void discard(int fd);
+  void maintain(std::time_t now = Clock::now());
+  int connect(void) const;
+
+  const std::string& getHost(void) const;
+  const std::string& getPort(void) const;
+  std::size_t idle(void) const;
+  std::size_t busy(void) const;
+
+ private:
+  struct Connection {
+    int fd;
+    std::time_t since;
+  };
+  typedef std::list<Connection> ConnectionType;
+
+  UpstreamPool(const UpstreamPool& origin);
+  UpstreamPool& operator=(const UpstreamPool& origin);
+
+  static bool isUsable(int fd);
+
+  const std::string host_;
+  const std::string port_;
+  struct sockaddr_in address_;
+
+  ConnectionType idle_;
+  std::size_t busy_;
+};
+
+#endif
@@ -7,17 +7,90 @@
 const std::string DEFAULT_ERROR_DIRECTORY = "html/default_error/";
 const std::string DEFAULT_ERROR_PAGE = "html/default_error/error.html";
 const std::string DEFAULT_PATH = "conf/default.conf";
+const std::string DEFAULT_MIME_TYPES = "conf/mime.types";
+const std::string DEFAULT_TYPE = "application/octet-stream";
 const std::string DEFAULT_PORT = "80";
 const std::string DIRECTORY_LISTING_PAGE = "static/autoindex_template.html";
 
 /* setting for data size */
 const int CAPABLE_EVENT_SIZE = 8;
 const std::size_t BUFFER_SIZE = 65536;
+const std::size_t STREAM_HIGH_WATERMARK = BUFFER_SIZE * 4;
+const std::size_t STREAM_LOW_WATERMARK = BUFFER_SIZE;
+const std::size_t HEADER_RESERVE_SIZE = 512;
 
 /* setting for max time */
 const std::time_t KEEPALIVE_TIMEOUT = 500;
 const std::time_t SESSION_TIMEOUT = 3600;
 const std::time_t CGI_TIMEOUT = 3;
 const std::string COOKIE_MAX_AGE = "3600";
+const std::time_t SUPERVISE_INTERVAL = 1;
+
+/* setting for sessions */
+const std::size_t SESSION_MAX_COUNT = 10000;
+const std::size_t SESSION_SWEEP_LIMIT = 256;
+const std::size_t SESSION_SHM_SLOTS = 16384;
+const std::size_t SESSION_SHM_SHARDS = 64;
+const std::size_t SESSION_SHM_ID_SIZE = 64;
+const std::size_t SESSION_SHM_DATA_SIZE = 440;
+const std::size_t SESSION_SNAPSHOT_MIN_RECORDS = 1024;
+const std::size_t SESSION_ID_BYTES = 16;
+const std::size_t SESSION_ID_BATCH_SIZE = 256;
+
+/* setting for CGI worker pool */
+const std::size_t CGI_POOL_MIN = 1;
+const std::size_t CGI_POOL_MAX = 4;
+const std::time_t CGI_POOL_IDLE_TIMEOUT = 60;
+const std::size_t CGI_POOL_MAX_REQUESTS = 1000;
+
+/* setting for CGI concurrency, 0 CGI_MAX_PROCESSES leaves only the total */
+const std::size_t CGI_MAX_PROCESSES_TOTAL = 64;
+const std::size_t CGI_MAX_PROCESSES = 0;
+const std::size_t CGI_QUEUE_SIZE = 128;
+const std::time_t CGI_QUEUE_TIMEOUT = 10;
+const std::time_t CGI_RETRY_AFTER = 5;
+
+/* setting for process table, exit statuses kept after the reap */
+const std::size_t PROCESS_EXIT_HISTORY = 256;
+
+/* setting for reverse proxy */
+const std::time_t PROXY_TIMEOUT = 60;
+const std::size_t PROXY_KEEPALIVE = 16;
+const std::time_t PROXY_KEEPALIVE_TIMEOUT = 60;
+const std::size_t PROXY_HEADER_LIMIT = BUFFER_SIZE;
+
+/* setting for upstream groups */
+const std::size_t UPSTREAM_WEIGHT = 1;
+const std::size_t UPSTREAM_MAX_FAILS = 1;
+const std::time_t UPSTREAM_FAIL_TIMEOUT = 10;
+const std::size_t UPSTREAM_VIRTUAL_NODES = 40;
+const std::time_t HEALTH_CHECK_INTERVAL = 5;
+const std::string HEALTH_CHECK_URI = "/";
+
+/* setting for response cache */
+const std::size_t CACHE_MAX_SIZE = 64 * 1024 * 1024;
+const std::size_t CACHE_MAX_ENTRY_SIZE = 1024 * 1024;
+const std::time_t CACHE_LOCK_TIMEOUT = 5;
+const std::size_t DISK_CACHE_MAX_SIZE = 1024 * 1024 * 1024;
+const std::size_t DISK_CACHE_SLOTS = 16384;
+const std::size_t DISK_CACHE_KEY_SIZE = 192;
+const std::size_t DISK_CACHE_SWEEP_SLOTS = 1024;
+
+/* setting for on-the-fly compression */
+const int GZIP_LEVEL = 6;
+const std::size_t GZIP_CACHE_MAX_SIZE = 16 * 1024 * 1024;
+const std::size_t GZIP_FILE_MAX_SIZE = 1024 * 1024;
+
+/* setting for access log */
+const std::size_t ACCESS_LOG_BUFFER_SIZE = 64 * 1024;
+const std::size_t ACCESS_LOG_DATAGRAM_SIZE = 2048;
+const std::string ACCESS_LOG_FORMAT_NAME = "combined";
+const std::string ACCESS_LOG_FORMAT =
+    "$remote_addr - - [$time_local] \"$request\" $status $bytes_sent "
+    "\"$http_referer\" \"$http_user_agent\" $request_time";
+
+/* setting for slow log, the threshold is in milliseconds */
+const std::size_t SLOW_LOG_THRESHOLD = 1000;
+const std::time_t SLOW_LOG_EXIT_WAIT = 5;
 
 #endif
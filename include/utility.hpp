@@ -1,27 +1,40 @@
 #ifndef UTILITY_HPP_
 #define UTILITY_HPP_
 
+#include <stdint.h>
+#include <sys/types.h>
+
 #include <sstream>
 #include <vector>
 
+#include "Clock.hpp"
 #include "ResponseStatus.hpp"
 #include "constant.hpp"
 
 /*====================*/
 //     utility.cpp    //
 /*====================*/
+bool acceptsEncoding(const std::string& accept_encoding,
+                     const std::string& coding);
 std::string formatTime(const char* format,
-                       std::time_t timestamp = std::time(NULL));
+                       std::time_t timestamp = Clock::now());
+std::size_t findHeaderEnd(const std::string& message,
+                          std::size_t& separator_size);
+uint64_t fnv1a(const std::string& data);
 std::size_t hexToInt(const std::string& value);
 bool isDirectory(const std::string& path);
 bool isNumber(const std::string& str);
+std::time_t parseTime(const char* format, const std::string& value);
 std::string readFile(const std::string& filename);
 int removeDirectory(const std::string& path);
+ssize_t sendFile(int socket, int fd, off_t offset, std::size_t size);
 std::vector<std::string> split(const std::string& content,
                                const std::string& delim = WHITESPACE);
 std::set<std::string> splitToSet(const std::string& content,
                                  const std::string& delim = WHITESPACE);
 std::size_t stoi(const std::string& value);
+std::string toHex(std::size_t value);
+std::string toLower(const std::string& str);
 std::string trim(const std::string& str);
 std::string getIpFromKey(const std::string key);
 std::string getPortFromKey(const std::string key);
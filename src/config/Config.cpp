@@ -3,14 +3,22 @@
 #include <cstdlib>
 
 #include "Error.hpp"
+#include "utility.hpp"
 
-Config::Config() {}
+Config::Config() { log_formats_[ACCESS_LOG_FORMAT_NAME] = ACCESS_LOG_FORMAT; }
 
-Config::Config(const Config& origin) : server_blocks_(origin.server_blocks_) {}
+Config::Config(const Config& origin)
+    : server_blocks_(origin.server_blocks_),
+      upstream_blocks_(origin.upstream_blocks_),
+      types_(origin.types_),
+      log_formats_(origin.log_formats_) {}
 
 Config& Config::operator=(const Config& origin) {
   if (this != &origin) {
     server_blocks_ = origin.server_blocks_;
+    upstream_blocks_ = origin.upstream_blocks_;
+    types_ = origin.types_;
+    log_formats_ = origin.log_formats_;
   }
   return *this;
 }
@@ -21,11 +29,38 @@ const std::vector<ServerBlock>& Config::getServerBlocks(void) const {
   return server_blocks_;
 }
 
+const std::vector<UpstreamBlock>& Config::getUpstreamBlocks(void) const {
+  return upstream_blocks_;
+}
+
+const std::map<std::string, std::string>& Config::getTypes(void) const {
+  return types_;
+}
+
+const std::map<std::string, std::string>& Config::getLogFormats(void) const {
+  return log_formats_;
+}
+
 void Config::addServerBlock(const ServerBlock& server_block) {
   validate(server_block);
   server_blocks_.push_back(server_block);
 }
 
+void Config::addUpstreamBlock(const UpstreamBlock& upstream_block) {
+  validate(upstream_block);
+  upstream_blocks_.push_back(upstream_block);
+}
+
+/* extensions are matched case-insensitively, a later type wins */
+void Config::addType(const std::string& type, const std::string& extension) {
+  types_[toLower(extension)] = type;
+}
+
+/* a later format of the same name wins, "combined" included */
+void Config::addLogFormat(const std::string& name, const std::string& format) {
+  log_formats_[name] = format;
+}
+
 void Config::validate(const ServerBlock& server_block) const {
   (void)server_block;
   // static std::size_t total_count;
@@ -37,3 +72,16 @@ void Config::validate(const ServerBlock& server_block) const {
   //   Error::log("Server configuration duplicated", "", EXIT_FAILURE);
   // }
 }
+
+/* an upstream needs a server and a name no other upstream uses */
+void Config::validate(const UpstreamBlock& upstream_block) const {
+  if (upstream_block.servers.empty() == true) {
+    Error::log("Upstream without server", upstream_block.name, EXIT_FAILURE);
+  }
+  for (std::vector<UpstreamBlock>::const_iterator it = upstream_blocks_.begin();
+       it != upstream_blocks_.end(); ++it) {
+    if (it->name == upstream_block.name) {
+      Error::log("Upstream duplicated", upstream_block.name, EXIT_FAILURE);
+    }
+  }
+}
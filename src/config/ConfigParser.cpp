@@ -22,6 +22,7 @@ ConfigParser::ConfigParser(const std::string& filename) : pos_(0) {
 ConfigParser::ConfigParser(const ConfigParser& origin)
     : config_(origin.config_),
       server_block_(origin.server_block_),
+      upstream_block_(origin.upstream_block_),
       location_block_(origin.location_block_),
       content_(origin.content_),
       pos_(origin.pos_) {}
@@ -30,6 +31,7 @@ ConfigParser& ConfigParser::operator=(const ConfigParser& origin) {
   if (this != &origin) {
     config_ = origin.config_;
     server_block_ = origin.server_block_;
+    upstream_block_ = origin.upstream_block_;
     location_block_ = origin.location_block_;
     content_ = origin.content_;
     pos_ = origin.pos_;
@@ -40,18 +42,104 @@ ConfigParser& ConfigParser::operator=(const ConfigParser& origin) {
 ConfigParser::~ConfigParser() {}
 
 const Config& ConfigParser::parse(void) {
-  while (peek() == "server") {
-    server_block_ = ServerBlock();
-    parseServerBlock();
-    config_.addServerBlock(server_block_);
+  while (true) {
+    std::string token = peek();
+    if (token == "server") {
+      server_block_ = ServerBlock();
+      parseServerBlock();
+      config_.addServerBlock(server_block_);
+    } else if (token == "upstream") {
+      upstream_block_ = UpstreamBlock();
+      parseUpstreamBlock();
+      config_.addUpstreamBlock(upstream_block_);
+    } else if (token == "include") {
+      parseInclude();
+    } else if (token == "types") {
+      parseTypes();
+    } else if (token == "log_format") {
+      parseLogFormat();
+    } else {
+      break;
+    }
   }
   std::string token = expect();
   if (!token.empty()) {
     Error::log(Error::INFO[ETOKEN], token, EXIT_FAILURE);
   }
+  if (config_.getTypes().empty() == true) {
+    loadDefaultTypes();
+  }
   return config_;
 }
 
+/* the named file is read in place of the directive */
+void ConfigParser::parseInclude(void) {
+  expect("include");
+  const std::string path = expect();
+  expect(";");
+  try {
+    content_.insert(pos_, readFile(path));
+  } catch (const std::exception& e) {
+    Error::log(e.what(), path, EXIT_FAILURE);
+  }
+}
+
+/* types { text/html html htm; ... } */
+void ConfigParser::parseTypes(void) {
+  expect("types");
+  expect("{");
+  while (peek() != "}") {
+    const std::string type = expect();
+    if (type.empty() == true || peek() == ";") {
+      Error::log(Error::INFO[ETOKEN], type, EXIT_FAILURE);
+    }
+    while (peek() != ";") {
+      const std::string extension = expect();
+      if (extension.empty() == true) {
+        Error::log(Error::INFO[ETOKEN], type, EXIT_FAILURE);
+      }
+      config_.addType(type, extension);
+    }
+    expect(";");
+  }
+  expect("}");
+}
+
+/* a configuration without types uses DEFAULT_MIME_TYPES when it exists */
+void ConfigParser::loadDefaultTypes(void) {
+  try {
+    content_ = readFile(DEFAULT_MIME_TYPES);
+  } catch (const std::exception& e) {
+    return;
+  }
+  pos_ = 0;
+  parseTypes();
+}
+
+/* log_format name $remote_addr [$time_local] "$request" ...;
+the tokens of the format are joined by single spaces. "json" and
+"binary" name the structured formats and can not be redefined */
+void ConfigParser::parseLogFormat(void) {
+  expect("log_format");
+  const std::string name = expect();
+  if (name == ACCESS_LOG_JSON || name == ACCESS_LOG_BINARY) {
+    Error::log(Error::INFO[ETOKEN], name, EXIT_FAILURE);
+  }
+  std::string format;
+  while (peek() != ";") {
+    const std::string token = expect();
+    if (token.empty() == true) {
+      Error::log(Error::INFO[ETOKEN], name, EXIT_FAILURE);
+    }
+    format += (format.empty() ? "" : " ") + token;
+  }
+  if (name.empty() == true || format.empty() == true) {
+    Error::log(Error::INFO[ETOKEN], name, EXIT_FAILURE);
+  }
+  config_.addLogFormat(name, format);
+  expect(";");
+}
+
 void ConfigParser::parseServerBlock(void) {
   expect("server");
   expect("{");
@@ -64,6 +152,14 @@ void ConfigParser::parseServerBlock(void) {
       parseServerName();
     } else if (token == "error_page") {
       parseErrorPage();
+    } else if (token == "session_shm") {
+      parseSessionShm();
+    } else if (token == "session_snapshot") {
+      parseSessionSnapshot();
+    } else if (token == "access_log") {
+      parseAccessLog();
+    } else if (token == "slow_log") {
+      parseSlowLog();
     } else if (token == "location") {
       location_block_.clear();
       parseLocation();
@@ -108,6 +204,65 @@ void ConfigParser::parseErrorPage(void) {
   expect(";");
 }
 
+/* sessions shared with every webserv mapping the same file */
+void ConfigParser::parseSessionShm(void) {
+  expect("session_shm");
+  server_block_.session_path = expect();
+  expect(";");
+}
+
+/* sessions journaled to a file and reloaded on start */
+void ConfigParser::parseSessionSnapshot(void) {
+  expect("session_snapshot");
+  server_block_.snapshot_path = expect();
+  expect(";");
+}
+
+/* access_log path [format]; a server may have several, "off" drops
+those before it. the format is "json", "binary" or one named by a
+log_format before the server, the path may be "unix:/path" of a
+datagram socket */
+void ConfigParser::parseAccessLog(void) {
+  expect("access_log");
+  const std::string path = expect();
+  std::string name = ACCESS_LOG_FORMAT_NAME;
+  if (peek() != ";") {
+    name = expect();
+  }
+  expect(";");
+  if (path == "off") {
+    server_block_.access_logs.clear();
+    return;
+  }
+  if (name == ACCESS_LOG_JSON || name == ACCESS_LOG_BINARY) {
+    server_block_.access_logs[path] = name;
+    return;
+  }
+  const std::map<std::string, std::string>& formats = config_.getLogFormats();
+  std::map<std::string, std::string>::const_iterator format =
+      formats.find(name);
+  if (format == formats.end()) {
+    Error::log(Error::INFO[ETOKEN], name, EXIT_FAILURE);
+  }
+  server_block_.access_logs[path] = format->second;
+}
+
+/* slow_log path [milliseconds]; requests slower than the threshold,
+SLOW_LOG_THRESHOLD by default */
+void ConfigParser::parseSlowLog(void) {
+  expect("slow_log");
+  server_block_.slow_log_path = expect();
+  if (peek() != ";") {
+    const std::string threshold = expect();
+    if (isNumber(threshold) == false) {
+      Error::log(Error::INFO[ETOKEN], threshold, EXIT_FAILURE);
+    }
+    server_block_.slow_log_threshold =
+        std::strtoul(threshold.c_str(), NULL, 10);
+  }
+  expect(";");
+}
+
 void ConfigParser::parseClientMaxBodySize(void) {
   expect("client_max_body_size");
   location_block_.setBodyLimit(expect());
@@ -131,10 +286,28 @@ void ConfigParser::parseLocation(void) {
       parseRoot();
     } else if (token == "autoindex") {
       parseAutoindex();
+    } else if (token == "gzip_static") {
+      parseGzipStatic();
+    } else if (token == "brotli_static") {
+      parseBrotliStatic();
+    } else if (token == "gzip") {
+      parseGzip();
+    } else if (token == "gzip_types") {
+      parseGzipTypes();
+    } else if (token == "gzip_min_length") {
+      parseGzipMinLength();
     } else if (token == "auth") {
       parseAuth();
     } else if (token == "index") {
       parseIndex();
+    } else if (token == "proxy_pass") {
+      parseProxyPass();
+    } else if (token == "cache_ttl") {
+      parseCacheTtl();
+    } else if (token == "cache_path") {
+      parseCachePath();
+    } else if (token == "stub_status") {
+      parseStubStatus();
     } else if (token.compare(0, 4, "CGI_") == 0) {
       parseCgiParams();
     } else {
@@ -142,6 +315,7 @@ void ConfigParser::parseLocation(void) {
     }
   }
   expect("}");
+  location_block_.compileHeaderBlock();
 }
 
 void ConfigParser::parseAllowedMethods(void) {
@@ -171,6 +345,38 @@ void ConfigParser::parseAutoindex(void) {
   expect(";");
 }
 
+void ConfigParser::parseGzipStatic(void) {
+  expect("gzip_static");
+  location_block_.setGzipStatic(expect());
+  expect(";");
+}
+
+void ConfigParser::parseBrotliStatic(void) {
+  expect("brotli_static");
+  location_block_.setBrotliStatic(expect());
+  expect(";");
+}
+
+void ConfigParser::parseGzip(void) {
+  expect("gzip");
+  location_block_.setGzip(expect());
+  expect(";");
+}
+
+void ConfigParser::parseGzipTypes(void) {
+  expect("gzip_types");
+  while (peek() != ";") {
+    location_block_.addGzipType(expect());
+  }
+  expect(";");
+}
+
+void ConfigParser::parseGzipMinLength(void) {
+  expect("gzip_min_length");
+  location_block_.setGzipMinLength(expect());
+  expect(";");
+}
+
 void ConfigParser::parseAuth(void) {
   expect("auth");
   location_block_.setAuth(expect());
@@ -193,6 +399,81 @@ void ConfigParser::parseCgiParams(void) {
   expect(";");
 }
 
+void ConfigParser::parseProxyPass(void) {
+  expect("proxy_pass");
+  location_block_.setProxyPass(expect());
+  expect(";");
+}
+
+void ConfigParser::parseCacheTtl(void) {
+  expect("cache_ttl");
+  location_block_.setCacheTtl(expect());
+  expect(";");
+}
+
+void ConfigParser::parseCachePath(void) {
+  expect("cache_path");
+  location_block_.setCachePath(expect());
+  expect(";");
+}
+
+/* stub_status [text | prometheus]; */
+void ConfigParser::parseStubStatus(void) {
+  expect("stub_status");
+  location_block_.setStubStatus((peek() == ";") ? "text" : expect());
+  expect(";");
+}
+
+void ConfigParser::parseUpstreamBlock(void) {
+  expect("upstream");
+  upstream_block_.name = expect();
+  expect("{");
+  while (true) {
+    std::string token = peek();
+    if (token == "}") break;
+    if (token == "server") {
+      parseUpstreamServer();
+    } else if (token == "balance") {
+      parseBalance();
+    } else if (token == "health_check") {
+      parseHealthCheck();
+    } else {
+      Error::log(Error::INFO[ETOKEN], token, EXIT_FAILURE);
+    }
+  }
+  expect("}");
+}
+
+void ConfigParser::parseUpstreamServer(void) {
+  expect("server");
+  UpstreamServer server(expect());
+  while (peek() != ";") {
+    server.setOption(expect());
+  }
+  upstream_block_.servers.push_back(server);
+  expect(";");
+}
+
+void ConfigParser::parseBalance(void) {
+  expect("balance");
+  std::vector<std::string> tokens;
+  while (peek() != ";") {
+    tokens.push_back(expect());
+  }
+  upstream_block_.setBalance(tokens);
+  expect(";");
+}
+
+void ConfigParser::parseHealthCheck(void) {
+  expect("health_check");
+  std::vector<std::string> tokens;
+  while (peek() != ";") {
+    tokens.push_back(expect());
+  }
+  upstream_block_.setHealthCheck(tokens);
+  expect(";");
+}
+
 std::string ConfigParser::expect(const std::string& expected) {
   skipWhitespace();
   std::string token;
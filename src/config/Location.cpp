@@ -7,6 +7,7 @@
 #include "ByteUnit.hpp"
 #include "Error.hpp"
 #include "constant.hpp"
+#include "utility.hpp"
 
 const std::string Location::DEFAULTS[] = {
     "100m",        // CLIENT_MAX_BODY_SIZE
@@ -14,15 +15,26 @@ const std::string Location::DEFAULTS[] = {
     "off",         // AUTOINDEX
     "off",         // AUTH
     "index.html",  // INDEX
+    "text/html",   // GZIP_TYPES
+    "20",          // GZIP_MIN_LENGTH
 };
 
-Location::Location() : root_(DEFAULTS[ROOT]) {
+Location::Location()
+    : root_(DEFAULTS[ROOT]),
+      gzip_static_(false),
+      brotli_static_(false),
+      gzip_(false),
+      is_cgi_(false),
+      cache_ttl_(0) {
   setBodyLimit(DEFAULTS[CLIENT_MAX_BODY_SIZE]);
   addAllowedMethod(METHODS[GET]);
   addAllowedMethod(METHODS[POST]);
   setAutoindex(DEFAULTS[AUTOINDEX]);
   setAuth(DEFAULTS[AUTH]);
   addIndex(DEFAULTS[INDEX]);
+  addGzipType(DEFAULTS[GZIP_TYPES]);
+  setGzipMinLength(DEFAULTS[GZIP_MIN_LENGTH]);
+  compileHeaderBlock();
 }
 
 Location::Location(const Location& origin)
@@ -32,10 +44,22 @@ Location::Location(const Location& origin)
       return_url_(origin.return_url_),
       root_(origin.root_),
       autoindex_(origin.autoindex_),
+      gzip_static_(origin.gzip_static_),
+      brotli_static_(origin.brotli_static_),
+      gzip_(origin.gzip_),
+      gzip_types_(origin.gzip_types_),
+      gzip_min_length_(origin.gzip_min_length_),
       auth_(origin.auth_),
       index_(origin.index_),
       cgi_param_(origin.cgi_param_),
-      is_cgi_(origin.is_cgi_) {}
+      is_cgi_(origin.is_cgi_),
+      proxy_host_(origin.proxy_host_),
+      proxy_port_(origin.proxy_port_),
+      proxy_uri_(origin.proxy_uri_),
+      cache_ttl_(origin.cache_ttl_),
+      cache_path_(origin.cache_path_),
+      header_block_(origin.header_block_),
+      stub_status_(origin.stub_status_) {}
 
 Location& Location::operator=(const Location& origin) {
   if (this != &origin) {
@@ -45,10 +69,22 @@ Location& Location::operator=(const Location& origin) {
     return_url_ = origin.return_url_;
     root_ = origin.root_;
     autoindex_ = origin.autoindex_;
+    gzip_static_ = origin.gzip_static_;
+    brotli_static_ = origin.brotli_static_;
+    gzip_ = origin.gzip_;
+    gzip_types_ = origin.gzip_types_;
+    gzip_min_length_ = origin.gzip_min_length_;
     auth_ = origin.auth_;
     index_ = origin.index_;
     cgi_param_ = origin.cgi_param_;
     is_cgi_ = origin.is_cgi_;
+    proxy_host_ = origin.proxy_host_;
+    proxy_port_ = origin.proxy_port_;
+    proxy_uri_ = origin.proxy_uri_;
+    cache_ttl_ = origin.cache_ttl_;
+    cache_path_ = origin.cache_path_;
+    header_block_ = origin.header_block_;
+    stub_status_ = origin.stub_status_;
   }
   return *this;
 }
@@ -82,6 +118,14 @@ const std::string& Location::getRoot(void) const { return root_; }
 
 bool Location::getAutoindex(void) const { return autoindex_; }
 
+bool Location::getGzipStatic(void) const { return gzip_static_; }
+
+bool Location::getBrotliStatic(void) const { return brotli_static_; }
+
+bool Location::getGzip(void) const { return gzip_; }
+
+std::size_t Location::getGzipMinLength(void) const { return gzip_min_length_; }
+
 bool Location::getAuth(void) const { return auth_; }
 
 std::vector<std::string>& Location::getIndex(void) { return index_; }
@@ -97,6 +141,33 @@ std::string Location::getCgiParam(const std::string& key) const {
   return cgi_param_.at(key);
 }
 
+/* numeric CGI_ directive, value if the location does not set it */
+std::size_t Location::getCgiParam(const std::string& key,
+                                  std::size_t value) const {
+  const std::string raw = getCgiParam(key);
+  if (raw.empty() == true) {
+    return value;
+  }
+  if (isNumber(raw) == false) {
+    Error::log(Error::INFO[ETOKEN], raw, EXIT_FAILURE);
+  }
+  return ::stoi(raw);
+}
+
+const std::string& Location::getProxyHost(void) const { return proxy_host_; }
+
+const std::string& Location::getProxyPort(void) const { return proxy_port_; }
+
+const std::string& Location::getProxyUri(void) const { return proxy_uri_; }
+std::time_t Location::getCacheTtl(void) const { return cache_ttl_; }
+const std::string& Location::getCachePath(void) const { return cache_path_; }
+
+const std::string& Location::getHeaderBlock(void) const {
+  return header_block_;
+}
+
+const std::string& Location::getStubStatus(void) const { return stub_status_; }
+
 void Location::setUri(const std::string& uri) { uri_ = uri; }
 
 void Location::setBodyLimit(const std::string& raw) {
@@ -130,6 +201,41 @@ void Location::setAutoindex(const std::string& raw) {
   autoindex_ = (raw == "on");
 }
 
+/* serve a file.gz sibling to clients accepting gzip */
+void Location::setGzipStatic(const std::string& raw) {
+  if (raw != "on" && raw != "off") {
+    Error::log(Error::INFO[ETOKEN], raw, EXIT_FAILURE);
+  }
+  gzip_static_ = (raw == "on");
+}
+
+/* serve a file.br sibling to clients accepting br */
+void Location::setBrotliStatic(const std::string& raw) {
+  if (raw != "on" && raw != "off") {
+    Error::log(Error::INFO[ETOKEN], raw, EXIT_FAILURE);
+  }
+  brotli_static_ = (raw == "on");
+}
+
+/* encode dynamic responses and static files on the fly */
+void Location::setGzip(const std::string& raw) {
+  if (raw != "on" && raw != "off") {
+    Error::log(Error::INFO[ETOKEN], raw, EXIT_FAILURE);
+  }
+  gzip_ = (raw == "on");
+}
+
+void Location::addGzipType(const std::string& type) {
+  gzip_types_.insert(toLower(type));
+}
+
+void Location::setGzipMinLength(const std::string& raw) {
+  if (raw.empty() == true || isNumber(raw) == false) {
+    Error::log(Error::INFO[ETOKEN], raw, EXIT_FAILURE);
+  }
+  gzip_min_length_ = ::stoi(raw);
+}
+
 void Location::setAuth(const std::string& raw) {
   if (raw != "on" && raw != "off") {
     Error::log(Error::INFO[ETOKEN], raw, EXIT_FAILURE);
@@ -144,10 +250,70 @@ void Location::addCgiParam(const std::string& key, const std::string& value) {
   is_cgi_ = true;
 }
 
+/* http://host[:port][/uri] */
+void Location::setProxyPass(const std::string& url) {
+  const std::string scheme = "http://";
+  if (url.compare(0, scheme.size(), scheme) != 0) {
+    Error::log(Error::INFO[ETOKEN], url, EXIT_FAILURE);
+  }
+  std::string authority = url.substr(scheme.size());
+  std::size_t slash = authority.find("/");
+  if (slash != std::string::npos) {
+    proxy_uri_ = authority.substr(slash);
+    authority.erase(slash);
+  }
+  std::size_t colon = authority.find(":");
+  proxy_host_ = authority.substr(0, colon);
+  proxy_port_ = (colon == std::string::npos) ? DEFAULT_PORT
+                                              : authority.substr(colon + 1);
+  if (proxy_host_.empty() == true || isNumber(proxy_port_) == false) {
+    Error::log(Error::INFO[ETOKEN], url, EXIT_FAILURE);
+  }
+}
+
+/* seconds a CGI or proxied response is kept in the cache, 0 is off */
+void Location::setCacheTtl(const std::string& raw) {
+  if (raw.empty() == true || isNumber(raw) == false) {
+    Error::log(Error::INFO[ETOKEN], raw, EXIT_FAILURE);
+  }
+  cache_ttl_ = ::stoi(raw);
+}
+
+/* directory keeping the cached responses across restarts */
+void Location::setCachePath(const std::string& path) {
+  if (path.empty() == true) {
+    Error::log(Error::INFO[ETOKEN], path, EXIT_FAILURE);
+  }
+  cache_path_ = path;
+}
+
+/* the location answers with the status page, "text" or "prometheus" */
+void Location::setStubStatus(const std::string& format) {
+  if (format != "text" && format != "prometheus") {
+    Error::log(Error::INFO[ETOKEN], format, EXIT_FAILURE);
+  }
+  stub_status_ = format;
+}
+
 bool Location::isAllowedMethod(const std::string& method) const {
   return allowed_methods_.find(method) != allowed_methods_.end();
 }
 
-bool Location::isCgi(void) { return is_cgi_; }
+/* a media type without parameters, "*" takes any */
+bool Location::isGzipType(const std::string& type) const {
+  return gzip_types_.find("*") != gzip_types_.end() ||
+         gzip_types_.find(type) != gzip_types_.end();
+}
+
+bool Location::isCgi(void) const { return is_cgi_; }
+
+bool Location::isProxy(void) const { return proxy_host_.empty() == false; }
+
+/* the header lines every response of the location carries, serialized
+once the location is parsed */
+void Location::compileHeaderBlock(void) {
+  header_block_ = "Server: Webserv" + CRLF;
+  header_block_ += "Allow: " + join(allowed_methods_, ", ") + CRLF;
+}
 
 void Location::clear(void) { *this = Location(); }
@@ -0,0 +1,91 @@
+#include "UpstreamBlock.hpp"
+
+#include <cstdlib>
+
+#include "Error.hpp"
+#include "constant.hpp"
+#include "utility.hpp"
+
+UpstreamServer::UpstreamServer()
+    : port(DEFAULT_PORT),
+      weight(UPSTREAM_WEIGHT),
+      max_fails(UPSTREAM_MAX_FAILS),
+      fail_timeout(UPSTREAM_FAIL_TIMEOUT) {}
+
+UpstreamServer::UpstreamServer(const std::string& token)
+    : port(DEFAULT_PORT),
+      weight(UPSTREAM_WEIGHT),
+      max_fails(UPSTREAM_MAX_FAILS),
+      fail_timeout(UPSTREAM_FAIL_TIMEOUT) {
+  std::vector<std::string> splitted = split(token, ":");
+  if (splitted.size() == 2) {
+    port = splitted[1];
+  }
+  if (splitted.empty() == true || 2 < splitted.size() ||
+      isNumber(port) == false) {
+    Error::log(Error::INFO[ETOKEN], token, EXIT_FAILURE);
+  }
+  host = splitted[0];
+}
+
+/* weight=N, max_fails=N or fail_timeout=N */
+void UpstreamServer::setOption(const std::string& token) {
+  std::size_t equal = token.find("=");
+  const std::string key = token.substr(0, equal);
+  const std::string value =
+      (equal == std::string::npos) ? "" : token.substr(equal + 1);
+
+  if (value.empty() == true || isNumber(value) == false) {
+    Error::log(Error::INFO[ETOKEN], token, EXIT_FAILURE);
+  }
+  if (key == "weight" && ::stoi(value) != 0) {
+    weight = ::stoi(value);
+  } else if (key == "max_fails") {
+    max_fails = ::stoi(value);
+  } else if (key == "fail_timeout") {
+    fail_timeout = ::stoi(value);
+  } else {
+    Error::log(Error::INFO[ETOKEN], token, EXIT_FAILURE);
+  }
+}
+
+UpstreamBlock::UpstreamBlock()
+    : balance(B_ROUND_ROBIN), check_interval(0), check_uri(HEALTH_CHECK_URI) {}
+
+/* round_robin, least_conn, hash uri or hash session */
+void UpstreamBlock::setBalance(const std::vector<std::string>& tokens) {
+  const std::string method = tokens.empty() ? "" : tokens[0];
+
+  if (method == "round_robin" && tokens.size() == 1) {
+    balance = B_ROUND_ROBIN;
+  } else if (method == "least_conn" && tokens.size() == 1) {
+    balance = B_LEAST_CONN;
+  } else if (method == "hash" && tokens.size() == 2 && tokens[1] == "uri") {
+    balance = B_HASH_URI;
+  } else if (method == "hash" && tokens.size() == 2 &&
+             tokens[1] == "session") {
+    balance = B_HASH_SESSION;
+  } else {
+    Error::log(Error::INFO[ETOKEN], join(tokens, " "), EXIT_FAILURE);
+  }
+}
+
+/* interval=N and uri=/path, both optional */
+void UpstreamBlock::setHealthCheck(const std::vector<std::string>& tokens) {
+  check_interval = HEALTH_CHECK_INTERVAL;
+  for (std::size_t i = 0; i < tokens.size(); ++i) {
+    std::size_t equal = tokens[i].find("=");
+    const std::string key = tokens[i].substr(0, equal);
+    const std::string value =
+        (equal == std::string::npos) ? "" : tokens[i].substr(equal + 1);
+
+    if (key == "interval" && value.empty() == false &&
+        isNumber(value) == true && ::stoi(value) != 0) {
+      check_interval = ::stoi(value);
+    } else if (key == "uri" && value.empty() == false && value[0] == '/') {
+      check_uri = value;
+    } else {
+      Error::log(Error::INFO[ETOKEN], tokens[i], EXIT_FAILURE);
+    }
+  }
+}
@@ -4,7 +4,7 @@ struct Response AutoIndexHandler::handle(Client *client) {
   struct Response response;
 
   response.body = generateBody(client);
-  response.headers["content-length"] = toString(response.body.size());
+  response.headers["Content-Type"] = "text/html";
 
   return response;
 }
@@ -0,0 +1,69 @@
+#include "CgiEnvironment.hpp"
+
+#include <unistd.h>
+
+#include <cstdio>
+
+#include "ResponseException.hpp"
+#include "utility.hpp"
+
+CgiEnvironment::CgiEnvironment(const int server_key,
+                               const Location& location) {
+  add(template_, "AUTH_TYPE", "");
+  const std::string& root = location.getRoot();
+  add(template_, "DOCUMENT_ROOT",
+      (root[0] == '/') ? root : getWorkingDirectory() + "/" + root);
+  add(template_, "GATEWAY_INTERFACE", "CGI/1.1");
+  add(template_, "REMOTE_HOST", "");
+  add(template_, "REMOTE_USER", "");
+  add(template_, "REMOTE_IDENT", "");
+  add(template_, "SERVER_PROTOCOL", "HTTP/1.1");
+  add(template_, "SERVER_SOFTWARE", "webserv/1.1");
+  add(template_, "HTTP_X_SERVER_KEY", toString(server_key));
+}
+
+CgiEnvironment::CgiEnvironment(const CgiEnvironment& origin)
+    : template_(origin.template_) {}
+
+CgiEnvironment& CgiEnvironment::operator=(const CgiEnvironment& origin) {
+  if (this != &origin) {
+    template_ = origin.template_;
+  }
+  return *this;
+}
+
+CgiEnvironment::~CgiEnvironment() {}
+
+/* the server never changes directory, so getcwd is needed only once */
+const std::string& CgiEnvironment::getWorkingDirectory(void) {
+  static std::string cwd;
+
+  if (cwd.empty() == true) {
+    char buf[FILENAME_MAX];
+    if (!getcwd(buf, FILENAME_MAX)) {
+      throw ResponseException(C500);
+    }
+    cwd = buf;
+  }
+  return cwd;
+}
+
+void CgiEnvironment::add(EntryType& entries, const std::string& key,
+                         const std::string& value) {
+  entries.push_back(key + "=" + value);
+}
+
+/* point envp at the entries, which must outlive the spawn */
+char** CgiEnvironment::toEnvp(EntryType& entries, std::vector<char*>& envp) {
+  envp.clear();
+  envp.reserve(entries.size() + 1);
+  for (EntryType::iterator it = entries.begin(); it != entries.end(); ++it) {
+    envp.push_back(const_cast<char*>(it->c_str()));
+  }
+  envp.push_back(NULL);
+  return &envp[0];
+}
+
+const CgiEnvironment::EntryType& CgiEnvironment::getTemplate(void) const {
+  return template_;
+}
@@ -5,16 +5,49 @@
 ========================*/
 
 void CgiHandler::execute(Client* client) {
+  CgiLimiter* limiter =
+      client->getHttpServer()->getCgiLimiter(client->getLocation().getUri());
+  if (limiter && limiter->acquire() == false) {
+    Process process;
+
+    limiter->enqueue(client);
+    process.limiter = limiter;
+    client->setProcess(process);
+    setPhase(client, P_QUEUED);
+    return;
+  }
+  try {
+    run(client);
+  } catch (const ResponseException& e) {
+    if (limiter) {
+      limiter->release();
+    }
+    throw;
+  }
+  client->getProcess().limiter = limiter;
+}
+
+void CgiHandler::run(Client* client) {
+  CgiWorkerPool* pool =
+      client->getHttpServer()->getCgiPool(client->getLocation().getUri());
+  if (pool) {
+    CgiWorker* worker = pool->acquire();
+    if (worker) {
+      dispatch(client, pool, worker);
+      return;
+    }
+  }
+
   int pipe_fds[2][2];
   Process process;
 
   std::string cgi_path = client->getLocation().getCgiParam("CGI_PATH");
   std::string uri = getAbsolutePath(client->getRequest().getUri());
 
-  if (pipe(pipe_fds[0]) == ERROR<int>()) {
+  if (Spawner::openPipe(pipe_fds[0]) == ERROR<int>()) {
     throw ResponseException(C500);
   }
-  if (pipe(pipe_fds[1]) == ERROR<int>()) {
+  if (Spawner::openPipe(pipe_fds[1]) == ERROR<int>()) {
     close(pipe_fds[0][READ]);
     close(pipe_fds[0][WRITE]);
 
@@ -23,49 +56,67 @@ void CgiHandler::execute(Client* client) {
 
   char* argv[3] = {const_cast<char*>(cgi_path.c_str()),
                    const_cast<char*>(uri.c_str()), NULL};
-  char** envp = generateEnvp(client);
+  CgiEnvironment::EntryType env = generateEnv(client);
+  std::vector<char*> envp;
+
+  int pid = Spawner::spawn(argv, CgiEnvironment::toEnvp(env, envp),
+                           pipe_fds[0][READ], pipe_fds[1][WRITE]);
 
-  int pid = fork();
+  close(pipe_fds[0][READ]);
+  close(pipe_fds[1][WRITE]);
 
   if (pid == ERROR<pid_t>()) {
-    deleteEnvp(envp);
-    close(pipe_fds[0][READ]);
     close(pipe_fds[0][WRITE]);
     close(pipe_fds[1][READ]);
-    close(pipe_fds[1][WRITE]);
 
     throw ResponseException(C500);
-  } else if (pid == 0) {
-    close(pipe_fds[0][WRITE]);
-    close(pipe_fds[1][READ]);
-    dup2(pipe_fds[0][READ], STDIN_FILENO);
-    dup2(pipe_fds[1][WRITE], STDOUT_FILENO);
-
-    execve(argv[0], argv, envp);
-    exit(EXIT_FAILURE);
   }
 
-  deleteEnvp(envp);
-  close(pipe_fds[0][READ]);
-  close(pipe_fds[1][WRITE]);
-
   process.pid = pid;
   process.input_fd = pipe_fds[1][READ];
   process.output_fd = pipe_fds[0][WRITE];
+  process.message_to_send = client->getRequest().getBody();
+  client->setProcess(process);
 
   if (fcntl(process.input_fd, F_SETFL, O_NONBLOCK) == ERROR<int>() ||
       fcntl(process.output_fd, F_SETFL, O_NONBLOCK) == ERROR<int>()) {
     cleanUp(client);
     throw ResponseException(C500);
   }
+  /* the exit is reaped by the ProcessTable, then passed to the client */
+  client->getServerManager()->createEvent(pid, EVFILT_PROC,
+                                          EV_ADD | EV_ONESHOT, NOTE_EXIT, 0,
+                                          client);
+  start(client);
+}
 
-  if (client->getRequest().getMethod() != METHODS[POST]) {
-    close(process.output_fd);
-  }
-  process.message_to_send = client->getRequest().getBody();
+/* pass the request to an idle persistent worker instead of forking */
+void CgiHandler::dispatch(Client* client, CgiWorkerPool* pool,
+                          CgiWorker* worker) {
+  Process process;
+
+  process.pid = worker->pid;
+  process.input_fd = worker->input_fd;
+  process.output_fd = worker->output_fd;
+  process.pool = pool;
+  process.worker = worker;
+  process.message_to_send = generateFrame(client);
   client->setProcess(process);
 
-  setPhase(client, P_WRITE);
+  start(client);
+}
+
+/* the output is read while the body is still being written,
+so a script answering early can not fill its pipe and deadlock */
+void CgiHandler::start(Client* client) {
+  Process& process = client->getProcess();
+
+  if (process.message_to_send.empty() == true) {
+    closeOutput(client);
+    setPhase(client, P_READ);
+  } else {
+    setPhase(client, P_WRITE);
+  }
   client->setAllTimeout();
   setTimer(client);
 }
@@ -74,21 +125,31 @@ void CgiHandler::execute(Client* client) {
  process depending on event_type(phase)
 ========================================*/
 
-void CgiHandler::handle(Client* client, int event_type) {
-  switch (event_type) {
+void CgiHandler::handle(Client* client, const struct kevent& event) {
+  const Process& process = client->getProcess();
+
+  switch (event.filter) {
     case EVFILT_READ:
-      readFromCgi(client);
+      if (event.ident == static_cast<uintptr_t>(process.input_fd)) {
+        readFromCgi(client);
+      }
       break;
     case EVFILT_WRITE:
-      sendToCgi(client);
+      if (event.ident == static_cast<uintptr_t>(process.output_fd)) {
+        sendToCgi(client);
+      }
       break;
     case EVFILT_PROC:
-      setPhase(client, P_READ);
+      if (process.phase == P_EXIT &&
+          event.ident == static_cast<uintptr_t>(process.pid)) {
+        finish(client);
+      }
       break;
     case EVFILT_TIMER:
-      throw ResponseException(C500);
+      throw ResponseException(C504);
   }
 }
+
 /*=========================//
  WRITE Phase
 ===========================*/
@@ -103,13 +164,17 @@ void CgiHandler::sendToCgi(Client* client) {
   write_bytes = ::write(process.output_fd, process.message_to_send.c_str(),
                         process.message_to_send.size());
   if (write_bytes == ERROR<std::size_t>()) {
-    throw ResponseException(C500);
+    if (process.worker) {
+      throw ResponseException(C502);
+    }
+    /* the script stopped reading, its output decides the response */
+    process.message_to_send.clear();
+  } else {
+    process.message_to_send.erase(0, write_bytes);
   }
-
-  process.message_to_send.erase(0, write_bytes);
   if (process.message_to_send.empty() == true) {
-    close(process.output_fd);
-    setPhase(client, P_WAIT);
+    closeOutput(client);
+    setPhase(client, P_READ);
   }
 }
 
@@ -118,21 +183,145 @@ void CgiHandler::sendToCgi(Client* client) {
 ===========================*/
 
 void CgiHandler::readFromCgi(Client* client) {
-  if (client->getProcess().phase != P_READ) {
+  Process& process = client->getProcess();
+  if (process.phase != P_WRITE && process.phase != P_READ) {
     return;
   }
-  Process& process = client->getProcess();
   char buffer[BUFFER_SIZE];
 
   std::size_t read_bytes = ::read(process.input_fd, buffer, BUFFER_SIZE);
 
   if (read_bytes == ERROR<std::size_t>()) {
-    throw ResponseException(C500);
+    throw ResponseException(C502);
   }
   if (read_bytes == 0) {
-    setPhase(client, P_DONE);
+    if (process.worker) {
+      throw ResponseException(C502);
+    }
+    finish(client);
+    return;
+  }
+  setTimer(client);
+  if (process.worker) {
+    unframe(client, buffer, read_bytes);
+    return;
+  }
+  deliver(client, buffer, read_bytes);
+}
+
+/* strip the "<length>\n" prefix of a worker's frame */
+void CgiHandler::unframe(Client* client, const char* data, std::size_t size) {
+  Process& process = client->getProcess();
+  std::size_t offset = 0;
+
+  while (process.frame_remaining == NPOS && offset < size) {
+    const char c = data[offset++];
+    if (c != LF[0]) {
+      process.frame_header += c;
+      continue;
+    }
+    if (process.frame_header.empty() == true ||
+        isNumber(process.frame_header) == false) {
+      throw ResponseException(C502);
+    }
+    process.frame_remaining = ::stoi(process.frame_header);
+  }
+  if (process.frame_remaining == NPOS) {
+    return;
+  }
+  std::size_t length = std::min(size - offset, process.frame_remaining);
+  process.frame_remaining -= length;
+  deliver(client, data + offset, length);
+  if (process.frame_remaining == 0) {
+    finish(client);
   }
-  process.message_received += std::string(buffer, read_bytes);
+}
+
+/* buffer the output until the end of its header, then stream the rest */
+void CgiHandler::deliver(Client* client, const char* data, std::size_t size) {
+  Process& process = client->getProcess();
+
+  if (process.stream.is_header_sent == true) {
+    ResponseStream::append(client, process.stream, process.input_fd, data,
+                           size);
+    return;
+  }
+  process.message_received.append(data, size);
+
+  std::size_t separator_size;
+  std::size_t boundary = findHeaderEnd(process.message_received,
+                                       separator_size);
+  if (boundary == NPOS) {
+    return;
+  }
+  sendHeader(client, boundary, separator_size);
+}
+
+/*=========================//
+ stream to the client
+===========================*/
+
+/* queue the response header, chunked unless the script set a length */
+void CgiHandler::sendHeader(Client* client, std::size_t boundary,
+                            std::size_t separator_size) {
+  Process& process = client->getProcess();
+  Response response;
+
+  response.headers =
+      generateHeader(process.message_received.substr(0, boundary));
+  const std::string body =
+      process.message_received.substr(boundary + separator_size);
+  process.message_received.clear();
+
+  ResponseStream::sendHeader(client, process.stream, response);
+  ResponseStream::append(client, process.stream, process.input_fd,
+                         body.c_str(), body.size());
+}
+
+void CgiHandler::drain(Client* client) {
+  Process& process = client->getProcess();
+
+  /* a paused pipe is waiting on the client, not on the script */
+  if (process.stream.is_paused == true) {
+    setTimer(client);
+  }
+  ResponseStream::drain(client, process.stream, process.input_fd);
+}
+
+/* the script is done. without a complete header the whole output is
+parsed at once by getResponse, otherwise the stream is terminated.
+a forked script is answered only once it is reaped, a failed one with 502
+or, when its header is already out, by closing the connection */
+void CgiHandler::finish(Client* client) {
+  Process& process = client->getProcess();
+
+  if (hasExited(client) == false) {
+    setPhase(client, P_EXIT);
+    return;
+  }
+  setPhase(client, P_DONE);
+  if (process.stream.is_header_sent == false) {
+    return;
+  }
+  process.phase = P_UNSTARTED;
+  ResponseStream::end(client, process.stream);
+}
+
+/* true once a forked script is reaped, throws if it failed */
+bool CgiHandler::hasExited(Client* client) {
+  const Process& process = client->getProcess();
+  int status;
+
+  if (process.worker) {
+    return true;
+  }
+  if (ProcessTable::findExit(process.pid, status) == false) {
+    return ProcessTable::isRunning(process.pid) == false;
+  }
+  if (WIFEXITED(status) == false || WEXITSTATUS(status) != 0) {
+    throw ResponseException(C502);
+  }
+  return true;
 }
 
 /*=========================//
@@ -145,14 +334,18 @@ struct Response CgiHandler::getResponse(Client* client) {
   process.phase = P_UNSTARTED;
 
   const std::string& message = process.message_received;
-  std::size_t boundary = message.find(DOUBLE_LF);
+  if (message.empty() == true) {
+    throw ResponseException(C502);
+  }
+  std::size_t separator_size;
+  std::size_t boundary = findHeaderEnd(message, separator_size);
 
   if (boundary == NPOS) {
     response.headers = generateHeader(message);
     return response;
   }
   response.headers = generateHeader(message.substr(0, boundary));
-  response.body = message.substr(boundary + DOUBLE_LF.size());
+  response.body = message.substr(boundary + separator_size);
 
   return response;
 }
@@ -161,12 +354,14 @@ std::map<std::string, std::string> CgiHandler::generateHeader(
     const std::string& headers) {
   std::map<std::string, std::string> splited_header;
   std::vector<std::string> header = split(headers, LF);
-  std::vector<std::string> pair;
 
   for (std::vector<std::string>::iterator it = header.begin();
        it != header.end(); ++it) {
-    pair = split(*it, ":");
-    splited_header[trim(pair[0])] = trim(pair[1]);
+    std::size_t colon = it->find(":");
+    if (colon == std::string::npos) {
+      continue;
+    }
+    splited_header[trim(it->substr(0, colon))] = trim(it->substr(colon + 1));
   }
   return splited_header;
 }
@@ -188,72 +383,68 @@ void CgiHandler::setTimer(Client* client) {
  utils
 ===========================*/
 
-/* generate Envp for CGI */
-char** CgiHandler::generateEnvp(const Client* client) {
+/* extend the location's environment template with the request */
+CgiEnvironment::EntryType CgiHandler::generateEnv(const Client* client) {
   const HttpRequest& request = client->getRequest();
   const TcpServer* server = client->getTcpServer();
-  std::map<std::string, std::string> env_map;
+  const CgiEnvironment* environment =
+      client->getHttpServer()->getCgiEnvironment(client->getLocation().getUri());
+  if (environment == NULL) {
+    throw ResponseException(C500);
+  }
+  CgiEnvironment::EntryType env = environment->getTemplate();
 
   const std::string& method = request.getMethod();
   std::size_t content_length = request.getContentLength();
   if (method == "POST" && content_length > 0) {
-    env_map["CONTENT_LENGTH"] = toString(content_length);
-  }
-  env_map["AUTH_TYPE"] = "";
-  env_map["CONTENT_TYPE"] = request.getHeader("CONTENT-TYPE");
-  env_map["GATEWAY_INTERFACE"] = "CGI/1.1";
-  env_map["PATH_INFO"] = request.getUri();
-  env_map["PATH_TRANSLATED"] = getAbsolutePath(request.getUri());
-  env_map["QUERY_STRING"] = request.getQueryString();
-  env_map["REMOTE_HOST"] = "";
-  env_map["REMOTE_ADDR"] = client->getAddr().getIP();
-  env_map["REMOTE_USER"] = "";
-  env_map["REMOTE_IDENT"] = "";
-  env_map["REQUEST_METHOD"] = method;
-  env_map["REQUEST_URI"] = request.getUri();
-  env_map["SCRIPT_NAME"] = request.getUri();
-  env_map["SERVER_NAME"] = server->getIp();
-  env_map["SERVER_PROTOCOL"] = "HTTP/1.1";
-  env_map["SERVER_PORT"] = server->getPort();
-  env_map["SERVER_SOFTWARE"] = "webserv/1.1";
-
-  env_map["HTTP_X_SERVER_KEY"] =
-      toString(client->getHttpServer()->getServerKey());
-  const Session* session = client->getSession();
-  if (session) {
-    env_map["HTTP_X_SESSION_ID"] = session->getID();
+    CgiEnvironment::add(env, "CONTENT_LENGTH", toString(content_length));
   }
+  CgiEnvironment::add(env, "CONTENT_TYPE", request.getHeader("CONTENT-TYPE"));
+  CgiEnvironment::add(env, "PATH_INFO", request.getUri());
+  CgiEnvironment::add(env, "PATH_TRANSLATED",
+                      getAbsolutePath(request.getUri()));
+  CgiEnvironment::add(env, "QUERY_STRING", request.getQueryString());
+  CgiEnvironment::add(env, "REMOTE_ADDR", client->getAddr().getIP());
+  CgiEnvironment::add(env, "REQUEST_METHOD", method);
+  CgiEnvironment::add(env, "REQUEST_URI", request.getUri());
+  CgiEnvironment::add(env, "SCRIPT_NAME", request.getUri());
+  CgiEnvironment::add(env, "SERVER_NAME", server->getIp());
+  CgiEnvironment::add(env, "SERVER_PORT", server->getPort());
 
-  char** envp = new char*[env_map.size() + 1];
-
-  int i = 0;
-  for (std::map<std::string, std::string>::const_iterator it = env_map.begin();
-       it != env_map.end(); ++it, ++i) {
-    envp[i] = strdup((it->first + "=" + it->second).c_str());
-    if (envp[i] == NULL) {
-      deleteEnvp(envp);
-      throw ResponseException(C500);
-    }
+  const Session* session = client->getSession();
+  if (session) {
+    CgiEnvironment::add(env, "HTTP_X_SESSION_ID", session->getID());
   }
-  envp[i] = NULL;
-  return envp;
+  return env;
 }
 
-/* delete Envp */
-void CgiHandler::deleteEnvp(char** envp) {
-  for (int i = 0; envp[i]; ++i) {
-    delete[] envp[i];
+/* serialize environment and body into a request frame for a worker */
+std::string CgiHandler::generateFrame(const Client* client) {
+  const CgiEnvironment::EntryType env = generateEnv(client);
+  std::string payload;
+
+  for (CgiEnvironment::EntryType::const_iterator it = env.begin();
+       it != env.end(); ++it) {
+    payload += *it + LF;
   }
-  delete[] envp;
+  payload += LF + client->getRequest().getBody();
+  return toString(payload.size()) + LF + payload;
 }
 
 /* generate absolute path using uri */
 std::string CgiHandler::getAbsolutePath(const std::string& uri) {
-  char buf[FILENAME_MAX];
-  if (!getcwd(buf, FILENAME_MAX)) {
-    throw ResponseException(C500);
+  return CgiEnvironment::getWorkingDirectory() + uri;
+}
+
+/* stop writing to the script. a worker keeps its pipe for the next request */
+void CgiHandler::closeOutput(Client* client) {
+  Process& process = client->getProcess();
+
+  if (process.worker || process.output_fd == DEFAULT_FD) {
+    return;
   }
-  return buf + uri;
+  close(process.output_fd);
+  process.output_fd = DEFAULT_FD;
 }
 
 /* set kevent depending on phase */
@@ -262,61 +453,117 @@ void CgiHandler::setPhase(Client* client, int phase) {
   Process& process = client->getProcess();
 
   switch (phase) {
+    case P_QUEUED:
+      manager->createEvent(client->getFd(), EVFILT_READ, EV_DISABLE, 0, 0,
+                           client);
+      process.phase = P_QUEUED;
+      break;
+
     case P_WRITE:
       manager->createEvent(client->getFd(), EVFILT_READ, EV_DISABLE, 0, 0,
                            client);
       manager->createEvent(process.output_fd, EVFILT_WRITE, EV_ADD | EV_ENABLE,
                            0, 0, client);
+      manager->createEvent(process.input_fd, EVFILT_READ, EV_ADD | EV_ENABLE, 0,
+                           0, client);
       process.phase = P_WRITE;
       break;
 
-    case P_WAIT:
-      manager->createEvent(process.pid, EVFILT_PROC, EV_ADD | EV_ENABLE,
-                           NOTE_EXIT, 0, client);
-      process.phase = P_WAIT;
-
-      break;
-
     case P_READ:
-      manager->createEvent(process.pid, 0, EV_DELETE, 0, 0, client);
-      manager->createEvent(process.input_fd, EVFILT_READ, EV_ADD | EV_ENABLE, 0,
-                           0, client);
+      if (process.worker) {
+        manager->createEvent(process.output_fd, EVFILT_WRITE, EV_DELETE, 0, 0,
+                             client);
+      }
+      manager->createEvent(client->getFd(), EVFILT_READ, EV_DISABLE, 0, 0,
+                           client);
+      /* output that already filled the buffer stays paused until drained */
+      if (process.stream.is_paused == false) {
+        manager->createEvent(process.input_fd, EVFILT_READ, EV_ADD | EV_ENABLE,
+                             0, 0, client);
+      }
       process.phase = P_READ;
       break;
 
-    case P_DONE:
+    /* the output is over, the timer still runs until the exit */
+    case P_EXIT:
       close(process.input_fd);
+      process.input_fd = DEFAULT_FD;
+      process.phase = P_EXIT;
+      break;
+
+    case P_DONE:
+      if (process.worker) {
+        manager->createEvent(process.input_fd, EVFILT_READ, EV_DELETE, 0, 0,
+                             client);
+        process.pool->release(process.worker);
+        process.worker = NULL;
+      } else if (process.input_fd != DEFAULT_FD) {
+        close(process.input_fd);
+      }
+      process.input_fd = DEFAULT_FD;
+      process.output_fd = DEFAULT_FD;
       if (CGI_TIMEOUT < KEEPALIVE_TIMEOUT && CGI_TIMEOUT < SESSION_TIMEOUT) {
         manager->createEvent(client->getFd(), EVFILT_TIMER, EV_DELETE, 0, 0,
                              client);
       }
-      manager->createEvent(client->getFd(), EVFILT_READ, EV_ENABLE, 0, 0,
-                           client);
       process.phase = P_DONE;
+      releaseSlot(client);
       break;
 
     case P_RESET:
       manager->createEvent(client->getFd(), EVFILT_READ, EV_ENABLE, 0, 0,
                            client);
-      manager->createEvent(process.output_fd, EVFILT_WRITE, EV_DELETE, 0, 0,
-                           client);
-      manager->createEvent(process.pid, EVFILT_PROC, EV_DELETE, 0, 0, client);
-      manager->createEvent(process.input_fd, EVFILT_READ, EV_DELETE, 0, 0,
-                           client);
+      if (process.phase == P_QUEUED) {
+        process.limiter->cancel(client);
+        process.limiter = NULL;
+        process.phase = P_UNSTARTED;
+        break;
+      }
+      if (process.output_fd != DEFAULT_FD) {
+        manager->createEvent(process.output_fd, EVFILT_WRITE, EV_DELETE, 0, 0,
+                             client);
+      }
+      if (process.input_fd != DEFAULT_FD) {
+        manager->createEvent(process.input_fd, EVFILT_READ, EV_DELETE, 0, 0,
+                             client);
+      }
       manager->createEvent(client->getFd(), EVFILT_TIMER, EV_DELETE, 0, 0,
                            client);
       process.phase = P_UNSTARTED;
       cleanUp(client);
+      releaseSlot(client);
   }
 }
 
 void CgiHandler::cleanUp(Client* client) {
   Process& process = client->getProcess();
-  kill(process.pid, SIGKILL);
-  if (process.input_fd != -1) {
-    close(process.input_fd);
+  if (process.worker) {
+    process.pool->retire(process.worker);
+    process.worker = NULL;
+  } else {
+    /* a reaped pid may already belong to another process */
+    if (ProcessTable::isRunning(process.pid) == true) {
+      kill(process.pid, SIGKILL);
+    }
+    if (process.input_fd != DEFAULT_FD) {
+      close(process.input_fd);
+    }
+    if (process.output_fd != DEFAULT_FD) {
+      close(process.output_fd);
+    }
   }
-  if (process.output_fd != -1) {
-    close(process.output_fd);
+  process.input_fd = DEFAULT_FD;
+  process.output_fd = DEFAULT_FD;
+}
+
+/* let the next queued request run */
+void CgiHandler::releaseSlot(Client* client) {
+  Process& process = client->getProcess();
+  CgiLimiter* limiter = process.limiter;
+
+  if (limiter == NULL) {
+    return;
   }
-}
\ No newline at end of file
+  process.limiter = NULL;
+  limiter->release();
+}
@@ -0,0 +1,142 @@
+#include "CgiLimiter.hpp"
+
+#include "Client.hpp"
+#include "Error.hpp"
+#include "exception.hpp"
+#include "setting.hpp"
+
+std::size_t CgiLimiter::running_total_ = 0;
+std::list<CgiLimiter*> CgiLimiter::limiters_;
+
+CgiLimiter::CgiLimiter(const Location& location)
+    : max_processes_(
+          location.getCgiParam("CGI_MAX_PROCESSES", CGI_MAX_PROCESSES)),
+      queue_size_(location.getCgiParam("CGI_QUEUE_SIZE", CGI_QUEUE_SIZE)),
+      queue_timeout_(
+          location.getCgiParam("CGI_QUEUE_TIMEOUT", CGI_QUEUE_TIMEOUT)),
+      running_(0),
+      peak_queued_(0),
+      rejected_(0),
+      expired_(0) {
+  if (queue_timeout_ == 0) {
+    Error::log(Error::INFO[ETOKEN], "CGI_QUEUE_TIMEOUT", EXIT_FAILURE);
+  }
+  limiters_.push_back(this);
+}
+
+CgiLimiter::~CgiLimiter() { limiters_.remove(this); }
+
+/*======================//
+ slot
+========================*/
+
+/* take a slot if both limits allow it */
+bool CgiLimiter::acquire(void) {
+  if (hasSlot() == false) {
+    return false;
+  }
+  ++running_;
+  ++running_total_;
+  return true;
+}
+
+/* give the slot back and let a waiting request run */
+void CgiLimiter::release(void) {
+  --running_;
+  --running_total_;
+  wakeUp();
+}
+
+/*======================//
+ queue
+========================*/
+
+/* wait for a slot, 503 if the queue is already full */
+void CgiLimiter::enqueue(Client* client, std::time_t now) {
+  if (queue_size_ <= queue_.size()) {
+    ++rejected_;
+    throw ResponseException(C503);
+  }
+  Waiter waiter;
+  waiter.client = client;
+  waiter.since = now;
+  queue_.push_back(waiter);
+  peak_queued_ = std::max(peak_queued_, queue_.size());
+}
+
+/* the client went away while waiting */
+void CgiLimiter::cancel(Client* client) {
+  for (QueueType::iterator it = queue_.begin(); it != queue_.end(); ++it) {
+    if (it->client == client) {
+      queue_.erase(it);
+      return;
+    }
+  }
+}
+
+/* answer 503 to requests waiting longer than the queue timeout.
+the clock has whole seconds, so never expire early */
+void CgiLimiter::expire(std::time_t now) {
+  while (queue_.empty() == false &&
+         queue_timeout_ < now - queue_.front().since) {
+    Client* client = queue_.front().client;
+    queue_.pop_front();
+    ++expired_;
+    client->resumeCgi(C503);
+  }
+}
+
+/*======================//
+ metrics
+========================*/
+
+std::size_t CgiLimiter::running(void) const { return running_; }
+std::size_t CgiLimiter::queued(void) const { return queue_.size(); }
+std::size_t CgiLimiter::peakQueued(void) const { return peak_queued_; }
+std::size_t CgiLimiter::rejected(void) const { return rejected_; }
+std::size_t CgiLimiter::expired(void) const { return expired_; }
+std::size_t CgiLimiter::runningTotal(void) { return running_total_; }
+
+std::size_t CgiLimiter::queuedTotal(void) {
+  std::size_t total = 0;
+  for (std::list<CgiLimiter*>::iterator it = limiters_.begin();
+       it != limiters_.end(); ++it) {
+    total += (*it)->queue_.size();
+  }
+  return total;
+}
+
+/*======================//
+ utils
+========================*/
+
+bool CgiLimiter::hasSlot(void) const {
+  if (max_processes_ != 0 && max_processes_ <= running_) {
+    return false;
+  }
+  return running_total_ < CGI_MAX_PROCESSES_TOTAL;
+}
+
+/* run the oldest waiter of any location with a free slot,
+until no waiter can run */
+void CgiLimiter::wakeUp(void) {
+  while (true) {
+    CgiLimiter* next = NULL;
+    for (std::list<CgiLimiter*>::iterator it = limiters_.begin();
+         it != limiters_.end(); ++it) {
+      if ((*it)->queue_.empty() == true || (*it)->hasSlot() == false) {
+        continue;
+      }
+      if (next == NULL ||
+          (*it)->queue_.front().since < next->queue_.front().since) {
+        next = *it;
+      }
+    }
+    if (next == NULL) {
+      return;
+    }
+    Client* client = next->queue_.front().client;
+    next->queue_.pop_front();
+    client->resumeCgi(C200);
+  }
+}
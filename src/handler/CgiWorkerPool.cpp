@@ -0,0 +1,170 @@
+#include "CgiWorkerPool.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cstdlib>
+
+#include "CgiHandler.hpp"
+#include "Error.hpp"
+#include "ProcessTable.hpp"
+#include "Spawner.hpp"
+#include "setting.hpp"
+
+CgiWorkerPool::CgiWorkerPool(const Location& location)
+    : cgi_path_(location.getCgiParam("CGI_PATH")),
+      worker_path_(location.getCgiParam("CGI_POOL_WORKER")),
+      min_workers_(location.getCgiParam("CGI_POOL_MIN", CGI_POOL_MIN)),
+      max_workers_(location.getCgiParam("CGI_POOL_MAX", CGI_POOL_MAX)),
+      idle_timeout_(location.getCgiParam("CGI_POOL_IDLE_TIMEOUT",
+                                         CGI_POOL_IDLE_TIMEOUT)),
+      max_requests_(location.getCgiParam("CGI_POOL_MAX_REQUESTS",
+                                         CGI_POOL_MAX_REQUESTS)) {
+  if (max_workers_ == 0 || max_workers_ < min_workers_) {
+    Error::log(Error::INFO[ETOKEN], "CGI_POOL_MAX", EXIT_FAILURE);
+  }
+}
+
+CgiWorkerPool::~CgiWorkerPool() {
+  while (workers_.empty() == false) {
+    retire(workers_.front());
+  }
+}
+
+/*======================//
+ dispatch
+========================*/
+
+/* hand out an idle worker, spawning one if the pool is not full.
+NULL means every worker is busy */
+CgiWorker* CgiWorkerPool::acquire(std::time_t now) {
+  for (WorkerType::iterator it = workers_.begin(); it != workers_.end();) {
+    CgiWorker* worker = *it++;
+    if (worker->is_busy == true) {
+      continue;
+    }
+    if (isAlive(worker) == false) {
+      retire(worker);
+      continue;
+    }
+    worker->is_busy = true;
+    worker->last_used = now;
+    return worker;
+  }
+  if (max_workers_ <= workers_.size()) {
+    return NULL;
+  }
+  CgiWorker* worker = spawn();
+  if (worker) {
+    worker->is_busy = true;
+    worker->last_used = now;
+  }
+  return worker;
+}
+
+/* give the worker back, recycle it once it served max requests */
+void CgiWorkerPool::release(CgiWorker* worker, std::time_t now) {
+  worker->is_busy = false;
+  worker->last_used = now;
+  if (max_requests_ != 0 && max_requests_ <= ++worker->served) {
+    retire(worker);
+  }
+}
+
+void CgiWorkerPool::retire(CgiWorker* worker) {
+  kill(worker->pid, SIGKILL);
+  close(worker->input_fd);
+  close(worker->output_fd);
+  workers_.remove(worker);
+  delete worker;
+}
+
+/*======================//
+ supervise
+========================*/
+
+/* reap dead and long idle workers, then refill up to the minimum */
+void CgiWorkerPool::maintain(std::time_t now) {
+  for (WorkerType::iterator it = workers_.begin(); it != workers_.end();) {
+    CgiWorker* worker = *it++;
+    if (worker->is_busy == true) {
+      continue;
+    }
+    if (isAlive(worker) == false ||
+        (min_workers_ < workers_.size() &&
+         idle_timeout_ <= now - worker->last_used)) {
+      retire(worker);
+    }
+  }
+  while (workers_.size() < min_workers_) {
+    if (spawn() == NULL) {
+      break;
+    }
+  }
+}
+
+std::size_t CgiWorkerPool::size(void) const { return workers_.size(); }
+
+std::size_t CgiWorkerPool::idle(void) const {
+  std::size_t count = 0;
+  for (WorkerType::const_iterator it = workers_.begin(); it != workers_.end();
+       ++it) {
+    if ((*it)->is_busy == false) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+/*======================//
+ utils
+========================*/
+
+/* start CGI_PATH with the worker script, stdin/stdout bound to pipes */
+CgiWorker* CgiWorkerPool::spawn(void) {
+  int pipe_fds[2][2];
+
+  if (Spawner::openPipe(pipe_fds[0]) == ERROR<int>()) {
+    return NULL;
+  }
+  if (Spawner::openPipe(pipe_fds[1]) == ERROR<int>()) {
+    close(pipe_fds[0][READ]);
+    close(pipe_fds[0][WRITE]);
+    return NULL;
+  }
+
+  char* argv[3] = {const_cast<char*>(cgi_path_.c_str()),
+                   const_cast<char*>(worker_path_.c_str()), NULL};
+  char* envp[3] = {const_cast<char*>("GATEWAY_INTERFACE=CGI/1.1"),
+                   const_cast<char*>("SERVER_SOFTWARE=webserv/1.1"), NULL};
+
+  int pid =
+      Spawner::spawn(argv, envp, pipe_fds[0][READ], pipe_fds[1][WRITE]);
+
+  close(pipe_fds[0][READ]);
+  close(pipe_fds[1][WRITE]);
+
+  if (pid == ERROR<pid_t>()) {
+    close(pipe_fds[0][WRITE]);
+    close(pipe_fds[1][READ]);
+    return NULL;
+  }
+
+  CgiWorker* worker = new CgiWorker();
+  worker->pid = pid;
+  worker->input_fd = pipe_fds[1][READ];
+  worker->output_fd = pipe_fds[0][WRITE];
+  workers_.push_back(worker);
+
+  if (fcntl(worker->input_fd, F_SETFL, O_NONBLOCK) == ERROR<int>() ||
+      fcntl(worker->output_fd, F_SETFL, O_NONBLOCK) == ERROR<int>()) {
+    retire(worker);
+    return NULL;
+  }
+  return worker;
+}
+
+bool CgiWorkerPool::isAlive(const CgiWorker* worker) const {
+  return ProcessTable::isRunning(worker->pid);
+}
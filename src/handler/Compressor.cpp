@@ -0,0 +1,258 @@
+#include "Compressor.hpp"
+
+#include <sys/stat.h>
+
+#include "Client.hpp"
+#include "ResponseStream.hpp"
+#include "utility.hpp"
+
+const std::string Compressor::CODINGS[] = {"identity", "gzip", "deflate"};
+
+std::map<std::string, Compressor::Entry> Compressor::entries_;
+std::list<std::string> Compressor::lru_;
+std::size_t Compressor::size_ = 0;
+Compressor::Stats Compressor::stats_;
+
+Compressor::Compressor() : is_started_(false) {}
+
+Compressor::~Compressor() {
+  if (is_started_ == true) {
+    deflateEnd(&stream_);
+  }
+}
+
+/*======================//
+ whole bodies
+========================*/
+
+/* encode a body held in memory, in place */
+void Compressor::encode(Client* client, Response& response) {
+  if (response.is_streamed == true || response.file_fd != DEFAULT_FD ||
+      response.body.size() < client->getLocation().getGzipMinLength()) {
+    return;
+  }
+  int coding = negotiate(client, response);
+  if (coding == IDENTITY) {
+    return;
+  }
+  std::string encoded;
+  deflateBody(response.body, coding, encoded);
+  response.body.swap(encoded);
+  setHeader(response, coding);
+}
+
+/* answer a static file from its encoded copy, made on the first miss.
+a file over GZIP_FILE_MAX_SIZE is sent as it is with sendfile rather than
+read and deflated on the loop */
+bool Compressor::encodeFile(Client* client, Response& response,
+                            const std::string& path) {
+  struct stat info;
+  if (client->getLocation().getGzip() == false ||
+      stat(path.c_str(), &info) == -1 || S_ISREG(info.st_mode) == false ||
+      static_cast<std::size_t>(info.st_size) <
+          client->getLocation().getGzipMinLength() ||
+      GZIP_FILE_MAX_SIZE < static_cast<std::size_t>(info.st_size)) {
+    return false;
+  }
+  int coding = negotiate(client, response);
+  if (coding == IDENTITY) {
+    return false;
+  }
+  const std::string key = CODINGS[coding] + " " + path;
+  std::map<std::string, Entry>::iterator entry = entries_.find(key);
+  if (entry != entries_.end() && entry->second.file_size == info.st_size &&
+      entry->second.mtime == info.st_mtime) {
+    lru_.splice(lru_.end(), lru_, entry->second.lru);
+    response.body = entry->second.body;
+    stats_.hits += 1;
+    setHeader(response, coding);
+    return true;
+  }
+  std::string body;
+  try {
+    body = readFile(path);
+  } catch (FileOpenException& e) {
+    return false;
+  }
+  Entry fresh;
+  fresh.file_size = info.st_size;
+  fresh.mtime = info.st_mtime;
+  deflateBody(body, coding, fresh.body);
+  response.body = fresh.body;
+  store(key, fresh);
+  stats_.misses += 1;
+  setHeader(response, coding);
+  return true;
+}
+
+/*======================//
+ streamed bodies
+========================*/
+
+/* the deflate state a streamed response goes through, NULL to send it as
+it is. the client owns it until clear */
+Compressor* Compressor::begin(Client* client, Response& response) {
+  for (std::map<std::string, std::string>::const_iterator it =
+           response.headers.begin();
+       it != response.headers.end(); ++it) {
+    if (toLower(it->first) == "content-length" &&
+        isNumber(it->second) == true &&
+        ::stoi(it->second) < client->getLocation().getGzipMinLength()) {
+      return NULL;
+    }
+  }
+  int coding = negotiate(client, response);
+  if (coding == IDENTITY) {
+    return NULL;
+  }
+  setHeader(response, coding);
+  Compressor* compressor = new Compressor();
+  compressor->start(coding);
+  client->setCompressor(compressor);
+  return compressor;
+}
+
+/* every chunk is flushed so the client sees it while the source is slow */
+void Compressor::update(const char* data, std::size_t size,
+                        std::string& out) {
+  stats_.bytes_in += size;
+  deflateData(data, size, Z_SYNC_FLUSH, out);
+}
+
+void Compressor::finish(std::string& out) {
+  deflateData(NULL, 0, Z_FINISH, out);
+}
+
+/*======================//
+ stats
+========================*/
+
+std::size_t Compressor::size(void) { return size_; }
+
+const Compressor::Stats& Compressor::getStats(void) { return stats_; }
+
+/*======================//
+ utils
+========================*/
+
+/* the coding to use, IDENTITY when the response stays as it is */
+int Compressor::negotiate(Client* client, Response& response) {
+  const Location& location = client->getLocation();
+  std::map<std::string, std::string>::const_iterator status =
+      response.headers.find("Status");
+  const bool has_body =
+      (status == response.headers.end())
+          ? client->getStatus() != C204
+          : status->second.compare(0, 3, ResponseStatus::CODES[C204]) != 0 &&
+                status->second.compare(0, 3, "304") != 0;
+
+  if (location.getGzip() == false || has_body == false ||
+      ResponseStream::hasHeader(response.headers, "Content-Encoding") ==
+          true ||
+      location.isGzipType(getType(response)) == false) {
+    return IDENTITY;
+  }
+  if (ResponseStream::hasHeader(response.headers, "Vary") == false) {
+    response.headers["Vary"] = "Accept-Encoding";
+  }
+  const std::string accept_encoding =
+      client->getRequest().getHeader("ACCEPT-ENCODING");
+  if (acceptsEncoding(accept_encoding, CODINGS[GZIP]) == true) {
+    return GZIP;
+  }
+  if (acceptsEncoding(accept_encoding, CODINGS[DEFLATE]) == true) {
+    return DEFLATE;
+  }
+  return IDENTITY;
+}
+
+/* the length changes with the coding, a streamed body goes chunked */
+void Compressor::setHeader(Response& response, int coding) {
+  std::map<std::string, std::string>::iterator it = response.headers.begin();
+  while (it != response.headers.end()) {
+    if (toLower(it->first) == "content-length") {
+      response.headers.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  response.headers["Content-Encoding"] = CODINGS[coding];
+  stats_.encoded += 1;
+}
+
+/* the media type without parameters, text/html when none is set */
+std::string Compressor::getType(const Response& response) {
+  for (std::map<std::string, std::string>::const_iterator it =
+           response.headers.begin();
+       it != response.headers.end(); ++it) {
+    if (toLower(it->first) == "content-type") {
+      return toLower(trim(it->second.substr(0, it->second.find(";"))));
+    }
+  }
+  return "text/html";
+}
+
+void Compressor::deflateBody(const std::string& body, int coding,
+                             std::string& out) {
+  Compressor compressor;
+
+  compressor.start(coding);
+  stats_.bytes_in += body.size();
+  compressor.deflateData(body.data(), body.size(), Z_FINISH, out);
+}
+
+void Compressor::store(const std::string& key, const Entry& entry) {
+  if (GZIP_CACHE_MAX_SIZE < entry.body.size()) {
+    return;
+  }
+  std::map<std::string, Entry>::iterator old = entries_.find(key);
+  if (old != entries_.end()) {
+    size_ -= old->second.body.size();
+    lru_.erase(old->second.lru);
+    entries_.erase(old);
+  }
+  Entry& stored = entries_[key];
+  stored = entry;
+  stored.lru = lru_.insert(lru_.end(), key);
+  size_ += stored.body.size();
+  evict();
+}
+
+/* drop the least recently used copies until under GZIP_CACHE_MAX_SIZE */
+void Compressor::evict(void) {
+  while (GZIP_CACHE_MAX_SIZE < size_ && lru_.empty() == false) {
+    std::map<std::string, Entry>::iterator entry = entries_.find(lru_.front());
+    size_ -= entry->second.body.size();
+    entries_.erase(entry);
+    lru_.pop_front();
+  }
+}
+
+/* windowBits 15 is a zlib stream, 31 adds the gzip wrapper */
+void Compressor::start(int coding) {
+  stream_.zalloc = Z_NULL;
+  stream_.zfree = Z_NULL;
+  stream_.opaque = Z_NULL;
+  if (deflateInit2(&stream_, GZIP_LEVEL, Z_DEFLATED,
+                   (coding == GZIP) ? 31 : 15, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw ResponseException(C500);
+  }
+  is_started_ = true;
+}
+
+void Compressor::deflateData(const char* data, std::size_t size, int flush,
+                             std::string& out) {
+  char buffer[BUFFER_SIZE];
+  const std::size_t before = out.size();
+
+  stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  stream_.avail_in = size;
+  do {
+    stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+    stream_.avail_out = BUFFER_SIZE;
+    deflate(&stream_, flush);
+    out.append(buffer, BUFFER_SIZE - stream_.avail_out);
+  } while (stream_.avail_out == 0);
+  stats_.bytes_out += out.size() - before;
+}
@@ -0,0 +1,348 @@
+#include "DiskCache.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Error.hpp"
+#include "utility.hpp"
+
+const char DiskCache::MAGIC[8] = {'W', 'S', 'C', 'A', 'C', 'H', 'E', '1'};
+std::map<std::string, DiskCache*> DiskCache::caches_;
+
+DiskCache::DiskCache(const std::string& path)
+    : path_(path),
+      index_fd_(DEFAULT_FD),
+      header_(NULL),
+      slots_(NULL),
+      sweep_cursor_(0),
+      positions_(DISK_CACHE_SLOTS) {
+  if (isDirectory(path_) == false &&
+      mkdir(path_.c_str(), 0755) == ERROR<int>()) {
+    Error::log(Error::INFO[ESYSTEM], path_, EXIT_FAILURE);
+  }
+  map();
+}
+
+DiskCache::~DiskCache() {
+  munmap(header_, sizeof(Header) + DISK_CACHE_SLOTS * sizeof(Slot));
+  close(index_fd_);
+}
+
+/*======================//
+ lookup
+========================*/
+
+/* on a hit the header block is parsed into response and the body is
+left in the open file */
+bool DiskCache::lookup(const std::string& key, Response& response,
+                       std::time_t now) {
+  std::size_t index = findSlot(key, fnv1a(key));
+  if (index == NPOS) {
+    stats_.misses += 1;
+    return false;
+  }
+  Slot& slot = slots_[index];
+  if (slot.expires <= now) {
+    erase(index);
+    stats_.misses += 1;
+    return false;
+  }
+
+  int fd = ::open(getFilePath(index).c_str(), O_RDONLY | O_CLOEXEC);
+  std::string header(slot.header_size, '\0');
+  struct stat statbuf;
+  if (fd == ERROR<int>() || fstat(fd, &statbuf) == ERROR<int>() ||
+      static_cast<uint64_t>(statbuf.st_size) != slot.size ||
+      pread(fd, &header[0], header.size(), 0) !=
+          static_cast<ssize_t>(header.size())) {
+    if (fd != ERROR<int>()) {
+      close(fd);
+    }
+    erase(index);
+    stats_.misses += 1;
+    return false;
+  }
+
+  std::vector<std::string> lines = split(header, LF);
+  for (std::size_t i = 0; i < lines.size(); ++i) {
+    const std::string line = trim(lines[i]);
+    std::size_t colon = line.find(":");
+    if (colon != std::string::npos) {
+      response.headers[line.substr(0, colon)] = trim(line.substr(colon + 1));
+    }
+  }
+  response.headers["Age"] = toString(now - slot.stored_at);
+  response.file_fd = fd;
+  response.file_offset = slot.header_size;
+  response.file_size = slot.size - slot.header_size;
+  slot.used_at = now;
+  lru_.splice(lru_.end(), lru_, positions_[index]);
+  stats_.hits += 1;
+  return true;
+}
+
+/*======================//
+ store
+========================*/
+
+/* the file is written aside and renamed into place, a reader never
+sees half of it */
+void DiskCache::store(const std::string& key, const Response& response,
+                      std::time_t ttl, std::time_t now) {
+  if (ttl <= 0 || DISK_CACHE_KEY_SIZE <= key.size()) {
+    return;
+  }
+  uint64_t key_hash = fnv1a(key);
+  std::size_t index = findSlot(key, key_hash);
+  if (index != NPOS) {
+    erase(index);
+  }
+  index = findFreeSlot(key_hash);
+  if (index == NPOS) {
+    return;
+  }
+  const std::string header = serialize(response);
+  if (writeFile(getFilePath(index), header + response.body) == false) {
+    return;
+  }
+
+  Slot& slot = slots_[index];
+  slot.hash = key_hash;
+  slot.size = header.size() + response.body.size();
+  slot.expires = now + ttl;
+  slot.stored_at = now;
+  slot.used_at = now;
+  slot.header_size = header.size();
+  slot.state = S_USED;
+  std::memset(slot.key, 0, sizeof(slot.key));
+  std::memcpy(slot.key, key.c_str(), key.size());
+  positions_[index] = lru_.insert(lru_.end(), index);
+  header_->size += slot.size;
+  stats_.stores += 1;
+}
+
+/*======================//
+ sweep
+========================*/
+
+/* check the next DISK_CACHE_SWEEP_SLOTS slots for expiry, then evict
+down to the size budget */
+void DiskCache::sweep(std::time_t now) {
+  for (std::size_t count = 0; count < DISK_CACHE_SWEEP_SLOTS; ++count) {
+    if (slots_[sweep_cursor_].state == S_USED &&
+        slots_[sweep_cursor_].expires <= now) {
+      erase(sweep_cursor_);
+    }
+    sweep_cursor_ = (sweep_cursor_ + 1) % DISK_CACHE_SLOTS;
+  }
+  evict();
+}
+
+/* least recently used first */
+void DiskCache::evict(void) {
+  while (DISK_CACHE_MAX_SIZE < header_->size && lru_.empty() == false) {
+    erase(lru_.front());
+    stats_.evictions += 1;
+  }
+  if (lru_.empty() == true) {
+    header_->size = 0;
+  }
+}
+
+/*======================//
+ registry
+========================*/
+
+void DiskCache::open(const std::string& path) {
+  if (caches_.find(path) == caches_.end()) {
+    caches_[path] = new DiskCache(path);
+  }
+}
+
+DiskCache* DiskCache::find(const std::string& path) {
+  std::map<std::string, DiskCache*>::iterator cache = caches_.find(path);
+
+  if (cache == caches_.end()) {
+    return NULL;
+  }
+  return cache->second;
+}
+
+void DiskCache::sweepAll(std::time_t now) {
+  for (std::map<std::string, DiskCache*>::iterator it = caches_.begin();
+       it != caches_.end(); ++it) {
+    it->second->sweep(now);
+  }
+}
+
+const std::map<std::string, DiskCache*>& DiskCache::getCaches(void) {
+  return caches_;
+}
+
+std::size_t DiskCache::size(void) const { return header_->size; }
+const DiskCache::Stats& DiskCache::getStats(void) const { return stats_; }
+
+/*======================//
+ index
+========================*/
+
+/* map the index, starting over when it was written with another
+layout */
+void DiskCache::map(void) {
+  const std::string index_path = path_ + "/index";
+  const std::size_t length = sizeof(Header) + DISK_CACHE_SLOTS * sizeof(Slot);
+  struct stat statbuf;
+
+  index_fd_ = ::open(index_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (index_fd_ == ERROR<int>() || fstat(index_fd_, &statbuf) == ERROR<int>()) {
+    Error::log(Error::INFO[EOPEN], index_path, EXIT_FAILURE);
+  }
+  bool is_resized = (static_cast<std::size_t>(statbuf.st_size) != length);
+  if (is_resized == true && (ftruncate(index_fd_, 0) == ERROR<int>() ||
+                             ftruncate(index_fd_, length) == ERROR<int>())) {
+    Error::log(Error::INFO[ESYSTEM], index_path, EXIT_FAILURE);
+  }
+  void* address =
+      mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, index_fd_, 0);
+  if (address == MAP_FAILED) {
+    Error::log(Error::INFO[ESYSTEM], index_path, EXIT_FAILURE);
+  }
+  header_ = static_cast<Header*>(address);
+  slots_ = reinterpret_cast<Slot*>(header_ + 1);
+  if (is_resized == true ||
+      std::memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header_->slots != DISK_CACHE_SLOTS ||
+      header_->key_size != DISK_CACHE_KEY_SIZE) {
+    reset();
+  }
+  order();
+}
+
+void DiskCache::reset(void) {
+  for (std::size_t i = 0; i < DISK_CACHE_SLOTS; ++i) {
+    unlink(getFilePath(i).c_str());
+  }
+  std::memset(header_, 0, sizeof(Header) + DISK_CACHE_SLOTS * sizeof(Slot));
+  std::memcpy(header_->magic, MAGIC, sizeof(MAGIC));
+  header_->slots = DISK_CACHE_SLOTS;
+  header_->key_size = DISK_CACHE_KEY_SIZE;
+}
+
+/* rebuild the recency list of a mapped index from the last use of
+its slots */
+void DiskCache::order(void) {
+  std::vector<std::pair<int64_t, std::size_t> > used;
+
+  for (std::size_t i = 0; i < DISK_CACHE_SLOTS; ++i) {
+    if (slots_[i].state == S_USED) {
+      used.push_back(std::make_pair(slots_[i].used_at, i));
+    }
+  }
+  std::sort(used.begin(), used.end());
+  lru_.clear();
+  for (std::size_t i = 0; i < used.size(); ++i) {
+    positions_[used[i].second] = lru_.insert(lru_.end(), used[i].second);
+  }
+}
+
+/* linear probing from the hash, up to the first never used slot */
+std::size_t DiskCache::findSlot(const std::string& key,
+                                uint64_t key_hash) const {
+  if (DISK_CACHE_KEY_SIZE <= key.size()) {
+    return NPOS;
+  }
+  for (std::size_t i = 0; i < DISK_CACHE_SLOTS; ++i) {
+    std::size_t index = (key_hash + i) % DISK_CACHE_SLOTS;
+    const Slot& slot = slots_[index];
+    if (slot.state == S_EMPTY) {
+      return NPOS;
+    }
+    if (slot.state == S_USED && slot.hash == key_hash && key == slot.key) {
+      return index;
+    }
+  }
+  return NPOS;
+}
+
+std::size_t DiskCache::findFreeSlot(uint64_t key_hash) const {
+  for (std::size_t i = 0; i < DISK_CACHE_SLOTS; ++i) {
+    std::size_t index = (key_hash + i) % DISK_CACHE_SLOTS;
+    if (slots_[index].state != S_USED) {
+      return index;
+    }
+  }
+  return NPOS;
+}
+
+/* a tombstone followed by a never used slot ends no probe, so it is
+turned back into one */
+void DiskCache::erase(std::size_t index) {
+  Slot& slot = slots_[index];
+
+  if (slot.state == S_USED) {
+    lru_.erase(positions_[index]);
+  }
+  unlink(getFilePath(index).c_str());
+  header_->size -= std::min(header_->size, slot.size);
+  slot.state = S_DELETED;
+  slot.hash = 0;
+  while (slots_[index].state == S_DELETED &&
+         slots_[(index + 1) % DISK_CACHE_SLOTS].state == S_EMPTY) {
+    slots_[index].state = S_EMPTY;
+    index = (index + DISK_CACHE_SLOTS - 1) % DISK_CACHE_SLOTS;
+  }
+}
+
+/*======================//
+ utils
+========================*/
+
+bool DiskCache::writeFile(const std::string& path,
+                          const std::string& data) const {
+  const std::string temporary = path + ".tmp";
+  int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0644);
+  if (fd == ERROR<int>()) {
+    return false;
+  }
+  std::size_t written = 0;
+  while (written < data.size()) {
+    ssize_t write_bytes =
+        write(fd, data.c_str() + written, data.size() - written);
+    if (write_bytes == ERROR<ssize_t>()) {
+      close(fd);
+      unlink(temporary.c_str());
+      return false;
+    }
+    written += write_bytes;
+  }
+  close(fd);
+  if (rename(temporary.c_str(), path.c_str()) == ERROR<int>()) {
+    unlink(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+std::string DiskCache::getFilePath(std::size_t index) const {
+  return path_ + "/" + toHex(index);
+}
+
+std::string DiskCache::serialize(const Response& response) {
+  std::string header;
+
+  for (std::map<std::string, std::string>::const_iterator it =
+           response.headers.begin();
+       it != response.headers.end(); ++it) {
+    header += it->first + ": " + it->second + CRLF;
+  }
+  return header + CRLF;
+}
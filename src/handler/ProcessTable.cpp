@@ -0,0 +1,96 @@
+#include "ProcessTable.hpp"
+
+#include <sys/wait.h>
+
+#include <algorithm>
+
+#include "constant.hpp"
+
+ProcessTable::EntryType ProcessTable::entries_;
+ProcessTable::StatsType ProcessTable::stats_;
+std::map<pid_t, int> ProcessTable::exits_;
+std::deque<pid_t> ProcessTable::exit_order_;
+
+void ProcessTable::add(pid_t pid, const std::string& script) {
+  Entry entry;
+
+  entry.script = script;
+  gettimeofday(&entry.started, NULL);
+  entries_[pid] = entry;
+  exits_.erase(pid);
+}
+
+/* collect every exited child without blocking */
+void ProcessTable::reap(void) {
+  struct rusage usage;
+  int status;
+  pid_t pid;
+
+  while ((pid = wait4(-1, &status, WNOHANG, &usage)) > 0) {
+    record(pid, status, usage);
+  }
+}
+
+/* false once the child is reaped, a zombie still counts as running
+until the next reap */
+bool ProcessTable::isRunning(pid_t pid) {
+  return entries_.find(pid) != entries_.end();
+}
+
+/* the wait status of a recently reaped child */
+bool ProcessTable::findExit(pid_t pid, int& status) {
+  std::map<pid_t, int>::const_iterator exit = exits_.find(pid);
+
+  if (exit == exits_.end()) {
+    return false;
+  }
+  status = exit->second;
+  return true;
+}
+
+std::size_t ProcessTable::size(void) { return entries_.size(); }
+
+const ProcessTable::StatsType& ProcessTable::getStats(void) { return stats_; }
+
+/*======================//
+ utils
+========================*/
+
+void ProcessTable::record(pid_t pid, int status,
+                          const struct rusage& usage) {
+  EntryType::iterator entry = entries_.find(pid);
+  if (entry == entries_.end()) {
+    return;
+  }
+  Stats& stats = stats_[entry->second.script];
+  struct timeval now;
+
+  gettimeofday(&now, NULL);
+  double wall_time = toSeconds(now) - toSeconds(entry->second.started);
+
+  ++stats.runs;
+  if (WIFEXITED(status) == false || WEXITSTATUS(status) != 0) {
+    ++stats.failures;
+  }
+  stats.last_status = status;
+  stats.user_time += toSeconds(usage.ru_utime);
+  stats.system_time += toSeconds(usage.ru_stime);
+  stats.wall_time += wall_time;
+  stats.max_wall_time = std::max(stats.max_wall_time, wall_time);
+  entries_.erase(entry);
+  remember(pid, status);
+}
+
+/* the oldest exit is forgotten first */
+void ProcessTable::remember(pid_t pid, int status) {
+  exits_[pid] = status;
+  exit_order_.push_back(pid);
+  while (exit_order_.size() > PROCESS_EXIT_HISTORY) {
+    exits_.erase(exit_order_.front());
+    exit_order_.pop_front();
+  }
+}
+
+double ProcessTable::toSeconds(const struct timeval& time) {
+  return time.tv_sec + time.tv_usec / 1000000.0;
+}
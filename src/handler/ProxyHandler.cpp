@@ -0,0 +1,560 @@
+#include "ProxyHandler.hpp"
+
+const std::string ProxyHandler::HOP_BY_HOP[] = {
+    "connection", "keep-alive", "proxy-connection", "te",
+    "trailer",    "upgrade",    "transfer-encoding",
+};
+
+/*======================//
+ execute proxy
+========================*/
+
+void ProxyHandler::execute(Client* client) {
+  UpstreamGroup* group = client->getHttpServer()->getUpstreamGroup(
+      client->getLocation().getUri());
+  ProxyConnection proxy;
+
+  if (group == NULL) {
+    throw ResponseException(C502);
+  }
+  proxy.group = group;
+  proxy.message_to_send = generateRequest(client);
+  client->setProxy(proxy);
+
+  connect(client);
+  client->setAllTimeout();
+  setTimer(client);
+}
+
+/* take a connection to a server of the group and start writing the
+request */
+void ProxyHandler::connect(Client* client) {
+  ProxyConnection& proxy = client->getProxy();
+
+  proxy.pool = proxy.group->select(client);
+  if (proxy.pool == NULL) {
+    throw ResponseException(C502);
+  }
+  proxy.fd = proxy.pool->acquire(proxy.is_reused);
+  if (proxy.fd == ERROR<int>()) {
+    proxy.fd = DEFAULT_FD;
+    proxy.group->fail(proxy.pool);
+    throw ResponseException(C502);
+  }
+  proxy.sent = 0;
+  setPhase(client, P_WRITE);
+}
+
+/* nothing came back yet, so the request is sent again: a kept-alive
+connection may just have been closed by the upstream, a new one failed
+and the next server of the group is tried, once each. a request that is
+not idempotent is sent again only if none of it was written, the upstream
+may have carried it out already */
+void ProxyHandler::retry(Client* client) {
+  ProxyConnection& proxy = client->getProxy();
+
+  if (proxy.message_received.empty() == false ||
+      proxy.stream.is_header_sent == true) {
+    throw ResponseException(C502);
+  }
+  proxy.pool->discard(proxy.fd);
+  proxy.fd = DEFAULT_FD;
+  if (proxy.is_reused == false) {
+    proxy.group->fail(proxy.pool);
+    proxy.tries += 1;
+    if (proxy.group->size() <= proxy.tries) {
+      throw ResponseException(C502);
+    }
+  }
+  if (proxy.sent != 0 &&
+      isIdempotent(client->getRequest().getMethod()) == false) {
+    throw ResponseException(C502);
+  }
+  connect(client);
+}
+
+/*======================================//
+ process depending on event_type(phase)
+========================================*/
+
+void ProxyHandler::handle(Client* client, const struct kevent& event) {
+  const ProxyConnection& proxy = client->getProxy();
+
+  switch (event.filter) {
+    case EVFILT_READ:
+      if (event.ident == static_cast<uintptr_t>(proxy.fd)) {
+        readFromUpstream(client);
+      }
+      break;
+    case EVFILT_WRITE:
+      if (event.ident == static_cast<uintptr_t>(proxy.fd)) {
+        sendToUpstream(client);
+      }
+      break;
+    case EVFILT_TIMER:
+      proxy.group->fail(proxy.pool);
+      throw ResponseException(C504);
+  }
+}
+
+void ProxyHandler::drain(Client* client) {
+  ProxyConnection& proxy = client->getProxy();
+
+  /* a paused upstream is waiting on the client, not the other way round */
+  if (proxy.stream.is_paused == true) {
+    setTimer(client);
+  }
+  ResponseStream::drain(client, proxy.stream, proxy.fd);
+}
+
+/*=========================//
+ WRITE Phase
+===========================*/
+
+void ProxyHandler::sendToUpstream(Client* client) {
+  ProxyConnection& proxy = client->getProxy();
+  if (proxy.phase != P_WRITE) {
+    return;
+  }
+  const std::string& message = proxy.message_to_send;
+
+  ssize_t write_bytes = ::send(proxy.fd, message.c_str() + proxy.sent,
+                               message.size() - proxy.sent, 0);
+  if (write_bytes == ERROR<ssize_t>()) {
+    if (errno != EAGAIN) {
+      retry(client);
+    }
+    return;
+  }
+  proxy.sent += write_bytes;
+  if (proxy.sent == message.size()) {
+    setPhase(client, P_READ);
+  }
+}
+
+/*=========================//
+ READ Phase
+===========================*/
+
+void ProxyHandler::readFromUpstream(Client* client) {
+  ProxyConnection& proxy = client->getProxy();
+  if (proxy.phase != P_WRITE && proxy.phase != P_READ) {
+    return;
+  }
+  char buffer[BUFFER_SIZE];
+
+  ssize_t read_bytes = ::recv(proxy.fd, buffer, BUFFER_SIZE, 0);
+  if (read_bytes == ERROR<ssize_t>()) {
+    if (errno != EAGAIN) {
+      retry(client);
+    }
+    return;
+  }
+  if (read_bytes == 0) {
+    if (proxy.stream.is_header_sent == false) {
+      retry(client);
+      return;
+    }
+    /* only a body without length ends with the connection */
+    if (proxy.is_chunked == true || proxy.body_remaining != NPOS) {
+      throw ResponseException(C502);
+    }
+    proxy.is_reusable = false;
+    finish(client);
+    return;
+  }
+  setTimer(client);
+  if (proxy.stream.is_header_sent == false) {
+    proxy.message_received.append(buffer, read_bytes);
+    parseHeader(client);
+    return;
+  }
+  parseBody(client, buffer, read_bytes);
+}
+
+/* forward the response header once complete, interim 1xx responses
+are dropped */
+void ProxyHandler::parseHeader(Client* client) {
+  ProxyConnection& proxy = client->getProxy();
+
+  while (true) {
+    std::size_t separator_size;
+    std::size_t boundary =
+        findHeaderEnd(proxy.message_received, separator_size);
+    if (boundary == NPOS) {
+      if (PROXY_HEADER_LIMIT < proxy.message_received.size()) {
+        throw ResponseException(C502);
+      }
+      return;
+    }
+    bool has_body;
+    Response response = generateResponse(
+        client, proxy.message_received.substr(0, boundary), has_body);
+    const std::string body =
+        proxy.message_received.substr(boundary + separator_size);
+    proxy.message_received.clear();
+
+    if (response.headers["Status"][0] == '1') {
+      proxy.message_received = body;
+      continue;
+    }
+    proxy.group->succeed(proxy.pool);
+    ResponseStream::sendHeader(client, proxy.stream, response, has_body);
+    if (has_body == false) {
+      proxy.is_reusable = proxy.is_reusable && body.empty();
+      finish(client);
+      return;
+    }
+    parseBody(client, body.c_str(), body.size());
+    return;
+  }
+}
+
+void ProxyHandler::parseBody(Client* client, const char* data,
+                             std::size_t size) {
+  ProxyConnection& proxy = client->getProxy();
+
+  if (proxy.is_chunked == true) {
+    decodeChunk(client, data, size);
+    return;
+  }
+  if (proxy.body_remaining == NPOS) {
+    ResponseStream::append(client, proxy.stream, proxy.fd, data, size);
+    return;
+  }
+  std::size_t length = std::min(size, proxy.body_remaining);
+  ResponseStream::append(client, proxy.stream, proxy.fd, data, length);
+  proxy.body_remaining -= length;
+  if (length < size) {
+    proxy.is_reusable = false;
+  }
+  if (proxy.body_remaining == 0) {
+    finish(client);
+  }
+}
+
+/* the payload of a chunked upstream body is streamed again with the
+framing the client connection uses. a chunk size or trailer line is
+collected in message_received */
+void ProxyHandler::decodeChunk(Client* client, const char* data,
+                               std::size_t size) {
+  ProxyConnection& proxy = client->getProxy();
+  std::size_t offset = 0;
+
+  while (offset < size) {
+    if (proxy.chunk_state == CHUNK_DATA) {
+      std::size_t length = std::min(size - offset, proxy.chunk_remaining);
+      ResponseStream::append(client, proxy.stream, proxy.fd, data + offset,
+                             length);
+      offset += length;
+      proxy.chunk_remaining -= length;
+      if (proxy.chunk_remaining == 0) {
+        proxy.chunk_state = CHUNK_DATA_END;
+      }
+      continue;
+    }
+    const char c = data[offset++];
+    if (c != LF[0]) {
+      proxy.message_received += c;
+      continue;
+    }
+    const std::string line = trim(proxy.message_received);
+    proxy.message_received.clear();
+
+    switch (proxy.chunk_state) {
+      case CHUNK_SIZE: {
+        const std::string chunk_size = trim(line.substr(0, line.find(";")));
+        if (chunk_size.empty() == true ||
+            chunk_size.find_first_not_of(BASE16) != std::string::npos) {
+          throw ResponseException(C502);
+        }
+        proxy.chunk_remaining = hexToInt(chunk_size);
+        proxy.chunk_state =
+            (proxy.chunk_remaining == 0) ? CHUNK_TRAILER : CHUNK_DATA;
+        break;
+      }
+      case CHUNK_DATA_END:
+        if (line.empty() == false) {
+          throw ResponseException(C502);
+        }
+        proxy.chunk_state = CHUNK_SIZE;
+        break;
+      case CHUNK_TRAILER:
+        if (line.empty() == true) {
+          proxy.is_reusable = proxy.is_reusable && (offset == size);
+          finish(client);
+          return;
+        }
+    }
+  }
+}
+
+void ProxyHandler::finish(Client* client) {
+  ProxyConnection& proxy = client->getProxy();
+
+  ResponseStream::end(client, proxy.stream);
+  setPhase(client, P_DONE);
+}
+
+/*=========================//
+ rewrite header
+===========================*/
+
+/* the request line and header for the upstream: hop-by-hop fields are
+dropped, the client is announced with X-Forwarded-* */
+std::string ProxyHandler::generateRequest(const Client* client) {
+  const HttpRequest& request = client->getRequest();
+  const Location& location = client->getLocation();
+  const HttpRequest::headers_type& headers = request.getHeaders();
+  const std::string client_ip = client->getAddr().getIP();
+  std::string forwarded_for = request.getHeader("X-FORWARDED-FOR");
+  std::string message;
+
+  message += request.getMethod() + " " + generatePath(client) + " HTTP/1.1" +
+             CRLF;
+  message += "Host: " + location.getProxyHost();
+  if (location.getProxyPort() != DEFAULT_PORT) {
+    message += ":" + location.getProxyPort();
+  }
+  message += CRLF;
+  for (HttpRequest::headers_type::const_iterator it = headers.begin();
+       it != headers.end(); ++it) {
+    const std::string name = toLower(it->first);
+    if (isHopByHop(name) == true || name == "host" ||
+        name == "content-length" || name == "expect" ||
+        name == "x-forwarded-for" || name == "x-real-ip") {
+      continue;
+    }
+    for (std::vector<std::string>::const_iterator value = it->second.begin();
+         value != it->second.end(); ++value) {
+      message += canonicalize(it->first) + ": " + *value + CRLF;
+    }
+  }
+  if (forwarded_for.empty() == false) {
+    forwarded_for += ", ";
+  }
+  message += "X-Forwarded-For: " + forwarded_for + client_ip + CRLF;
+  message += "X-Real-IP: " + client_ip + CRLF;
+  message += "X-Forwarded-Host: " + request.getHeader("HOST") + CRLF;
+  message += "X-Forwarded-Proto: http" + CRLF;
+  message += "Connection: keep-alive" + CRLF;
+  if (request.getBody().empty() == false ||
+      request.getMethod() == METHODS[POST] ||
+      request.getMethod() == METHODS[PUT]) {
+    message += "Content-Length: " + toString(request.getBody().size()) + CRLF;
+  }
+  message += CRLF;
+  message += request.getBody();
+
+  return message;
+}
+
+/* the location prefix is replaced by the uri of proxy_pass, if any */
+std::string ProxyHandler::generatePath(const Client* client) {
+  const HttpRequest& request = client->getRequest();
+  const Location& location = client->getLocation();
+  const std::string& prefix = location.getUri();
+  std::string path = request.getUri();
+
+  if (location.getProxyUri().empty() == false &&
+      path.compare(0, prefix.size(), prefix) == 0) {
+    path = location.getProxyUri() + path.substr(prefix.size());
+  }
+  if (request.getQueryString().empty() == false) {
+    path += "?" + request.getQueryString();
+  }
+  return path;
+}
+
+/* parse the upstream status line and header, keeping what the client
+should see and learning how the body is framed */
+Response ProxyHandler::generateResponse(Client* client,
+                                        const std::string& header,
+                                        bool& has_body) {
+  ProxyConnection& proxy = client->getProxy();
+  std::vector<std::string> lines = split(header, LF);
+  Response response;
+
+  std::vector<std::string> status_line =
+      split(lines.empty() ? "" : trim(lines[0]), " ");
+  if (status_line.size() < 2 || status_line[0].compare(0, 7, "HTTP/1.") != 0 ||
+      status_line[1].size() != 3 || isNumber(status_line[1]) == false) {
+    throw ResponseException(C502);
+  }
+  const std::string& code = status_line[1];
+  std::size_t reason = trim(lines[0]).find(code) + code.size();
+  response.headers["Status"] = code + trim(lines[0]).substr(reason);
+
+  if (status_line[0] == "HTTP/1.0") {
+    proxy.is_reusable = false;
+  }
+  proxy.is_chunked = false;
+  proxy.body_remaining = NPOS;
+  has_body = (client->getRequest().getMethod() != METHODS[HEAD] &&
+              code[0] != '1' && code != "204" && code != "304");
+
+  for (std::size_t i = 1; i < lines.size(); ++i) {
+    const std::string line = trim(lines[i]);
+    std::size_t colon = line.find(":");
+    if (colon == std::string::npos) {
+      continue;
+    }
+    const std::string name = trim(line.substr(0, colon));
+    const std::string key = toLower(name);
+    std::string value = trim(line.substr(colon + 1));
+
+    if (key == "transfer-encoding") {
+      proxy.is_chunked = (toLower(value).find("chunked") != std::string::npos);
+    }
+    if (key == "connection" &&
+        toLower(value).find("close") != std::string::npos) {
+      proxy.is_reusable = false;
+    }
+    if (isHopByHop(key) == true || key == "date" || key == "server") {
+      continue;
+    }
+    if (key == "content-length") {
+      if (isNumber(value) == false) {
+        throw ResponseException(C502);
+      }
+      proxy.body_remaining = ::stoi(value);
+    }
+    if (key == "location") {
+      value = rewriteLocation(client, value);
+    }
+    /* cookies may not be folded into one line */
+    if (key == "set-cookie") {
+      response.cookies.push_back(value);
+      continue;
+    }
+    if (response.headers.find(name) != response.headers.end()) {
+      response.headers[name] += ", " + value;
+      continue;
+    }
+    response.headers[name] = value;
+  }
+
+  if (proxy.is_chunked == true) {
+    std::map<std::string, std::string>::iterator it = response.headers.begin();
+    while (it != response.headers.end()) {
+      if (toLower(it->first) == "content-length") {
+        response.headers.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    proxy.body_remaining = NPOS;
+  } else if (proxy.body_remaining == NPOS && has_body == true) {
+    proxy.is_reusable = false;
+  }
+  return response;
+}
+
+/* a redirect to the upstream itself points back to the location */
+std::string ProxyHandler::rewriteLocation(const Client* client,
+                                          const std::string& location) {
+  const Location& proxied = client->getLocation();
+  const std::string upstream = "http://" + proxied.getProxyHost() + ":" +
+                               proxied.getProxyPort() + proxied.getProxyUri();
+
+  if (location.compare(0, upstream.size(), upstream) != 0) {
+    return location;
+  }
+  const std::string prefix =
+      proxied.getProxyUri().empty() ? "" : proxied.getUri();
+  return prefix + location.substr(upstream.size());
+}
+
+/*=========================//
+ set Timer
+===========================*/
+
+void ProxyHandler::setTimer(Client* client) {
+  if (KEEPALIVE_TIMEOUT < PROXY_TIMEOUT || SESSION_TIMEOUT < PROXY_TIMEOUT) {
+    return;
+  }
+  client->getServerManager()->createEvent(client->getFd(), EVFILT_TIMER,
+                                          EV_ADD | EV_ONESHOT, NOTE_SECONDS,
+                                          PROXY_TIMEOUT, client);
+}
+
+/*=========================//
+ utils
+===========================*/
+
+/* set kevent depending on phase */
+void ProxyHandler::setPhase(Client* client, int phase) {
+  ServerManager* manager = client->getServerManager();
+  ProxyConnection& proxy = client->getProxy();
+
+  switch (phase) {
+    case P_WRITE:
+      manager->createEvent(client->getFd(), EVFILT_READ, EV_DISABLE, 0, 0,
+                           client);
+      manager->createEvent(proxy.fd, EVFILT_WRITE, EV_ADD | EV_ENABLE, 0, 0,
+                           client);
+      manager->createEvent(proxy.fd, EVFILT_READ, EV_ADD | EV_ENABLE, 0, 0,
+                           client);
+      proxy.phase = P_WRITE;
+      break;
+
+    case P_READ:
+      manager->createEvent(proxy.fd, EVFILT_WRITE, EV_DELETE, 0, 0, client);
+      proxy.phase = P_READ;
+      break;
+
+    /* park the connection for the next request if the exchange ended
+    cleanly on both sides */
+    case P_DONE:
+      if (proxy.phase == P_READ && proxy.is_reusable == true) {
+        manager->createEvent(proxy.fd, EVFILT_READ, EV_DELETE, 0, 0, client);
+        proxy.pool->release(proxy.fd);
+      } else {
+        proxy.pool->discard(proxy.fd);
+      }
+      proxy.fd = DEFAULT_FD;
+      if (PROXY_TIMEOUT < KEEPALIVE_TIMEOUT && PROXY_TIMEOUT < SESSION_TIMEOUT) {
+        manager->createEvent(client->getFd(), EVFILT_TIMER, EV_DELETE, 0, 0,
+                             client);
+      }
+      proxy.phase = P_UNSTARTED;
+      break;
+
+    case P_RESET:
+      manager->createEvent(client->getFd(), EVFILT_READ, EV_ENABLE, 0, 0,
+                           client);
+      if (proxy.fd != DEFAULT_FD) {
+        proxy.pool->discard(proxy.fd);
+        proxy.fd = DEFAULT_FD;
+      }
+      manager->createEvent(client->getFd(), EVFILT_TIMER, EV_DELETE, 0, 0,
+                           client);
+      proxy.phase = P_UNSTARTED;
+  }
+}
+
+bool ProxyHandler::isIdempotent(const std::string& method) {
+  return method == METHODS[GET] || method == METHODS[HEAD] ||
+         method == METHODS[PUT] || method == METHODS[DELETE] ||
+         method == METHODS[OPTIONS];
+}
+
+bool ProxyHandler::isHopByHop(const std::string& name) {
+  const std::size_t count = sizeof(HOP_BY_HOP) / sizeof(HOP_BY_HOP[0]);
+
+  return std::find(HOP_BY_HOP, HOP_BY_HOP + count, name) != HOP_BY_HOP + count;
+}
+
+/* CONTENT-TYPE -> Content-Type, the parser keeps names upper case */
+std::string ProxyHandler::canonicalize(const std::string& name) {
+  std::string canonical = toLower(name);
+  bool is_word_start = true;
+
+  for (std::size_t i = 0; i < canonical.size(); ++i) {
+    if (is_word_start == true) {
+      canonical[i] = std::toupper(canonical[i]);
+    }
+    is_word_start = (canonical[i] == '-');
+  }
+  return canonical;
+}
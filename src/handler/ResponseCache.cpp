@@ -0,0 +1,334 @@
+#include "ResponseCache.hpp"
+
+#include <vector>
+
+#include "Client.hpp"
+#include "DiskCache.hpp"
+#include "utility.hpp"
+
+ResponseCache::EntryType ResponseCache::entries_;
+std::list<std::string> ResponseCache::lru_;
+ResponseCache::FillType ResponseCache::fills_;
+std::map<Client*, std::string> ResponseCache::clients_;
+std::size_t ResponseCache::size_ = 0;
+ResponseCache::Stats ResponseCache::stats_;
+
+/*======================//
+ lookup
+========================*/
+
+/* HIT fills response. on MISS the client fills the entry, on WAIT it
+is resumed once another client did. PASS runs the request uncached */
+int ResponseCache::lookup(Client* client, Response& response,
+                          std::time_t now) {
+  const std::string key = generateKey(client);
+  EntryType::iterator entry = entries_.find(key);
+
+  if (entry != entries_.end() && entry->second.expires <= now) {
+    remove(entry);
+    entry = entries_.end();
+  }
+  if (entry != entries_.end() && entry->second.is_pass == true) {
+    stats_.passes += 1;
+    return CACHE_PASS;
+  }
+  if (entry != entries_.end()) {
+    lru_.splice(lru_.end(), lru_, entry->second.lru);
+    response = entry->second.response;
+    response.headers["Age"] = toString(now - entry->second.stored_at);
+    stats_.hits += 1;
+    return CACHE_HIT;
+  }
+  DiskCache* disk = DiskCache::find(client->getLocation().getCachePath());
+  if (disk != NULL && disk->lookup(key, response, now) == true) {
+    stats_.hits += 1;
+    return CACHE_HIT;
+  }
+  /* a HEAD response has no body to fill the entry with */
+  if (client->getRequest().getMethod() == METHODS[HEAD]) {
+    stats_.passes += 1;
+    return CACHE_PASS;
+  }
+  FillType::iterator fill = fills_.find(key);
+  if (fill == fills_.end()) {
+    Fill& new_fill = fills_[key];
+    new_fill.owner = client;
+    new_fill.since = now;
+    new_fill.ttl = 0;
+    clients_[client] = key;
+    stats_.misses += 1;
+    return CACHE_MISS;
+  }
+  if (CACHE_LOCK_TIMEOUT <= now - fill->second.since) {
+    stats_.passes += 1;
+    return CACHE_PASS;
+  }
+  fill->second.waiters.push_back(client);
+  clients_[client] = key;
+  client->getServerManager()->createEvent(client->getFd(), EVFILT_READ,
+                                          EV_DISABLE, 0, 0, client);
+  stats_.coalesced += 1;
+  return CACHE_WAIT;
+}
+
+/*======================//
+ fill
+========================*/
+
+/* called with the header of the filling response. false if it is not
+captured: another client fills, or the response may not be cached */
+bool ResponseCache::begin(Client* client, const Response& response,
+                          std::time_t now) {
+  if (isFilling(client) == false) {
+    return false;
+  }
+  const std::string key = clients_[client];
+  std::time_t ttl = getTtl(client, response, now);
+  if (ttl == 0) {
+    store(key, Response(), client->getLocation().getCacheTtl(), true, now);
+    release(key);
+    return false;
+  }
+  Fill& fill = fills_[key];
+  fill.ttl = ttl;
+  for (std::map<std::string, std::string>::const_iterator it =
+           response.headers.begin();
+       it != response.headers.end(); ++it) {
+    const std::string name = toLower(it->first);
+    if (name != "content-length" && name != "transfer-encoding") {
+      fill.response.headers[it->first] = it->second;
+    }
+  }
+  return true;
+}
+
+/* false once the body outgrew CACHE_MAX_ENTRY_SIZE */
+bool ResponseCache::append(Client* client, const char* data,
+                           std::size_t size) {
+  if (isFilling(client) == false) {
+    return false;
+  }
+  const std::string key = clients_[client];
+  Fill& fill = fills_[key];
+  if (CACHE_MAX_ENTRY_SIZE < fill.response.body.size() + size) {
+    store(key, Response(), client->getLocation().getCacheTtl(), true,
+          Clock::now());
+    release(key);
+    return false;
+  }
+  fill.response.body.append(data, size);
+  return true;
+}
+
+void ResponseCache::commit(Client* client, std::time_t now) {
+  if (isFilling(client) == false) {
+    return;
+  }
+  const std::string key = clients_[client];
+  const Fill& fill = fills_[key];
+  store(key, fill.response, fill.ttl, false, now);
+  stats_.stores += 1;
+  DiskCache* disk = DiskCache::find(client->getLocation().getCachePath());
+  if (disk != NULL) {
+    disk->store(key, fill.response, fill.ttl, now);
+  }
+  release(key);
+}
+
+/* the client is done or gone: a waiter leaves the queue, an unfinished
+fill wakes its waiters so that one of them takes it over */
+void ResponseCache::cancel(Client* client) {
+  std::map<Client*, std::string>::iterator it = clients_.find(client);
+  if (it == clients_.end()) {
+    return;
+  }
+  const std::string key = it->second;
+  clients_.erase(it);
+
+  FillType::iterator fill = fills_.find(key);
+  if (fill == fills_.end()) {
+    return;
+  }
+  if (fill->second.owner == client) {
+    release(key);
+    return;
+  }
+  fill->second.waiters.remove(client);
+}
+
+/*======================//
+ supervise
+========================*/
+
+/* drop stale entries, let the waiters of a slow fill run on their own */
+void ResponseCache::expire(std::time_t now) {
+  for (EntryType::iterator it = entries_.begin(); it != entries_.end();) {
+    EntryType::iterator entry = it++;
+    if (entry->second.expires <= now) {
+      remove(entry);
+    }
+  }
+
+  std::vector<Client*> waiters;
+  for (FillType::iterator it = fills_.begin(); it != fills_.end(); ++it) {
+    if (CACHE_LOCK_TIMEOUT <= now - it->second.since) {
+      waiters.insert(waiters.end(), it->second.waiters.begin(),
+                     it->second.waiters.end());
+      it->second.waiters.clear();
+    }
+  }
+  for (std::size_t i = 0; i < waiters.size(); ++i) {
+    clients_.erase(waiters[i]);
+    waiters[i]->resumeFromCache();
+  }
+}
+
+/*======================//
+ getter
+========================*/
+
+bool ResponseCache::isFilling(Client* client) {
+  std::map<Client*, std::string>::const_iterator it = clients_.find(client);
+  if (it == clients_.end()) {
+    return false;
+  }
+  FillType::const_iterator fill = fills_.find(it->second);
+  return (fill != fills_.end() && fill->second.owner == client);
+}
+
+std::size_t ResponseCache::size(void) { return size_; }
+std::size_t ResponseCache::entries(void) { return entries_.size(); }
+const ResponseCache::Stats& ResponseCache::getStats(void) { return stats_; }
+
+/*======================//
+ utils
+========================*/
+
+std::string ResponseCache::generateKey(const Client* client) {
+  const HttpRequest& request = client->getRequest();
+  std::string key = toString(client->getHttpServer()->getServerKey()) + " " +
+                    METHODS[GET] + " " + request.getUri();
+
+  if (request.getQueryString().empty() == false) {
+    key += "?" + request.getQueryString();
+  }
+  return key;
+}
+
+/* seconds the response may be kept, 0 if it may not be cached.
+s-maxage and max-age come before Expires, which comes before the
+cache_ttl of the location */
+std::time_t ResponseCache::getTtl(const Client* client,
+                                  const Response& response, std::time_t now) {
+  const std::time_t UNSET = -1;
+  std::time_t max_age = UNSET;
+  std::time_t shared_max_age = UNSET;
+  std::time_t expires = UNSET;
+
+  if (response.cookies.empty() == false) {
+    return 0;
+  }
+  for (std::map<std::string, std::string>::const_iterator it =
+           response.headers.begin();
+       it != response.headers.end(); ++it) {
+    const std::string name = toLower(it->first);
+    if (name == "status" && it->second.compare(0, 3, "200") != 0) {
+      return 0;
+    }
+    if (name == "set-cookie") {
+      return 0;
+    }
+    if (name == "expires") {
+      expires = parseTime("%a, %d %b %Y %H:%M:%S GMT", it->second);
+      expires = (expires == ERROR<std::time_t>()) ? now : expires;
+    }
+    if (name != "cache-control") {
+      continue;
+    }
+    std::vector<std::string> directives = split(toLower(it->second), ",");
+    for (std::size_t i = 0; i < directives.size(); ++i) {
+      const std::string directive = trim(directives[i]);
+      std::size_t equal = directive.find("=");
+      const std::string value =
+          (equal == std::string::npos) ? "" : directive.substr(equal + 1);
+
+      if (directive == "no-store" || directive == "no-cache" ||
+          directive == "private") {
+        return 0;
+      }
+      if (value.empty() == true || isNumber(value) == false) {
+        continue;
+      }
+      if (directive.compare(0, equal, "max-age") == 0) {
+        max_age = ::stoi(value);
+      } else if (directive.compare(0, equal, "s-maxage") == 0) {
+        shared_max_age = ::stoi(value);
+      }
+    }
+  }
+  if (shared_max_age != UNSET) {
+    return shared_max_age;
+  }
+  if (max_age != UNSET) {
+    return max_age;
+  }
+  if (expires != UNSET) {
+    return (now < expires) ? expires - now : 0;
+  }
+  return client->getLocation().getCacheTtl();
+}
+
+/* replace the entry of key, then evict from the least recently used */
+void ResponseCache::store(const std::string& key, const Response& response,
+                          std::time_t ttl, bool is_pass, std::time_t now) {
+  EntryType::iterator old = entries_.find(key);
+  if (old != entries_.end()) {
+    remove(old);
+  }
+  Entry& entry = entries_[key];
+  entry.response = response;
+  entry.stored_at = now;
+  entry.expires = now + ttl;
+  entry.is_pass = is_pass;
+  entry.lru = lru_.insert(lru_.end(), key);
+  size_ += sizeOf(response);
+
+  while (CACHE_MAX_SIZE < size_ && lru_.empty() == false) {
+    remove(entries_.find(lru_.front()));
+    stats_.evictions += 1;
+  }
+}
+
+void ResponseCache::remove(EntryType::iterator entry) {
+  size_ -= sizeOf(entry->second.response);
+  lru_.erase(entry->second.lru);
+  entries_.erase(entry);
+}
+
+/* end the fill of key and resume its waiters */
+void ResponseCache::release(const std::string& key) {
+  FillType::iterator fill = fills_.find(key);
+  if (fill == fills_.end()) {
+    return;
+  }
+  const std::list<Client*> waiters = fill->second.waiters;
+  clients_.erase(fill->second.owner);
+  fills_.erase(fill);
+
+  for (std::list<Client*>::const_iterator it = waiters.begin();
+       it != waiters.end(); ++it) {
+    clients_.erase(*it);
+    (*it)->resumeFromCache();
+  }
+}
+
+std::size_t ResponseCache::sizeOf(const Response& response) {
+  std::size_t size = response.body.size();
+
+  for (std::map<std::string, std::string>::const_iterator it =
+           response.headers.begin();
+       it != response.headers.end(); ++it) {
+    size += it->first.size() + it->second.size();
+  }
+  return size;
+}
@@ -0,0 +1,115 @@
+#include "ResponseStream.hpp"
+
+#include "Client.hpp"
+#include "Compressor.hpp"
+#include "ResponseCache.hpp"
+#include "utility.hpp"
+
+/* queue the status line and header, the body follows through append */
+void ResponseStream::sendHeader(Client* client, Stream& stream,
+                                Response& response, bool has_body) {
+  client->markPhase(Metrics::HANDLE);
+  stream.is_captured = ResponseCache::begin(client, response);
+  stream.is_encoded =
+      (has_body == true && Compressor::begin(client, response) != NULL);
+  response.is_streamed = true;
+  stream.is_chunked =
+      (has_body == true &&
+       hasHeader(response.headers, "Content-Length") == false);
+  if (stream.is_chunked == true) {
+    response.headers["Transfer-Encoding"] = "chunked";
+  }
+  ResponseGenerator::generateResponse(*client, response);
+  client->markPhase(Metrics::GENERATE);
+  stream.is_header_sent = true;
+  client->setToSend(true);
+}
+
+void ResponseStream::append(Client* client, Stream& stream, int source_fd,
+                            const char* data, std::size_t size) {
+  std::string& response = client->getResponse();
+
+  if (size == 0 || client->getRequest().getMethod() == METHODS[HEAD]) {
+    return;
+  }
+  if (stream.is_captured == true) {
+    stream.is_captured = ResponseCache::append(client, data, size);
+  }
+  std::string encoded;
+  if (stream.is_encoded == true) {
+    client->getCompressor()->update(data, size, encoded);
+    data = encoded.data();
+    size = encoded.size();
+  }
+  if (stream.is_chunked == true) {
+    response += toHex(size) + CRLF;
+  }
+  response.append(data, size);
+  if (stream.is_chunked == true) {
+    response += CRLF;
+  }
+  client->getServerManager()->createEvent(client->getFd(), EVFILT_WRITE,
+                                          EV_ENABLE, 0, 0, client);
+  if (STREAM_HIGH_WATERMARK <= response.size() && stream.is_paused == false) {
+    pause(client, stream, source_fd);
+  }
+}
+
+/* stop reading the source until the client socket took the backlog */
+void ResponseStream::pause(Client* client, Stream& stream, int source_fd) {
+  client->getServerManager()->createEvent(source_fd, EVFILT_READ, EV_DISABLE,
+                                          0, 0, client);
+  client->getServerManager()->createEvent(client->getFd(), EVFILT_WRITE,
+                                          EV_ENABLE, 0, 0, client);
+  stream.is_paused = true;
+}
+
+/* called after the client socket took data: resume a paused source,
+stop polling the socket while there is nothing to send */
+void ResponseStream::drain(Client* client, Stream& stream, int source_fd) {
+  const std::string& response = client->getResponse();
+  ServerManager* manager = client->getServerManager();
+
+  if (stream.is_paused == true && response.size() <= STREAM_LOW_WATERMARK) {
+    manager->createEvent(source_fd, EVFILT_READ, EV_ENABLE, 0, 0, client);
+    stream.is_paused = false;
+  }
+  if (response.empty() == true) {
+    manager->createEvent(client->getFd(), EVFILT_WRITE, EV_DISABLE, 0, 0,
+                         client);
+  }
+}
+
+/* terminate the body once the source is done */
+void ResponseStream::end(Client* client, Stream& stream) {
+  if (stream.is_encoded == true &&
+      client->getRequest().getMethod() != METHODS[HEAD]) {
+    std::string encoded;
+    client->getCompressor()->finish(encoded);
+    client->getResponse() += toHex(encoded.size()) + CRLF + encoded + CRLF;
+  }
+  if (stream.is_chunked == true &&
+      client->getRequest().getMethod() != METHODS[HEAD]) {
+    client->getResponse() += "0" + DOUBLE_CRLF;
+  }
+  client->getServerManager()->createEvent(client->getFd(), EVFILT_WRITE,
+                                          EV_ENABLE, 0, 0, client);
+  if (stream.is_captured == true) {
+    stream.is_captured = false;
+    ResponseCache::commit(client);
+  }
+}
+
+bool ResponseStream::hasHeader(
+    const std::map<std::string, std::string>& headers,
+    const std::string& name) {
+  const std::string key = toLower(name);
+
+  for (std::map<std::string, std::string>::const_iterator it = headers.begin();
+       it != headers.end(); ++it) {
+    if (toLower(it->first) == key) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -1,5 +1,16 @@
 #include "SessionHandler.hpp"
 
+#include <stdint.h>
+#include <sys/random.h>
+
+#include <cstring>
+
+const char SessionHandler::BASE64URL[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+unsigned char SessionHandler::entropy_[SESSION_ID_BATCH_SIZE];
+std::size_t SessionHandler::entropy_pos_ = SESSION_ID_BATCH_SIZE;
+
 bool SessionHandler::recognizeRequest(HttpRequest &request) {
   if (request.getMethod() != METHODS[POST]) {
     return false;
@@ -21,35 +32,68 @@ struct Response SessionHandler::handle(Client *client) {
   return response;
 }
 
+/* two of 2^128 random IDs meet only with a broken entropy source, which
+is refused rather than retried */
 std::string SessionHandler::getNewSessionId(HttpServer *server) {
-  std::string id;
-  do {
-    id = createSessionId();
-  } while (server->isExistSessionId(id) == true);
+  std::string id = createSessionId();
+
+  if (server->isExistSessionId(id) == true) {
+    throw ResponseException(C500);
+  }
   return id;
 }
 
+/* SESSION_ID_BYTES random bytes in base64url without padding, taken from
+a batch filled by the kernel so a login burst costs one call per batch */
 std::string SessionHandler::createSessionId(void) {
-  srand(time(NULL));
-
+  if (SESSION_ID_BATCH_SIZE - entropy_pos_ < SESSION_ID_BYTES) {
+    fillEntropy();
+  }
+  const unsigned char *bytes = entropy_ + entropy_pos_;
   std::string id;
-  id.reserve(16);
-  for (int i = 0; i != 16; ++i) {
-    id += 'a' + (rand() % 16);
+
+  id.reserve((SESSION_ID_BYTES * 4 + 2) / 3);
+  for (std::size_t i = 0; i < SESSION_ID_BYTES; i += 3) {
+    uint32_t group = bytes[i] << 16;
+    if (i + 1 < SESSION_ID_BYTES) {
+      group |= bytes[i + 1] << 8;
+    }
+    if (i + 2 < SESSION_ID_BYTES) {
+      group |= bytes[i + 2];
+    }
+    id += BASE64URL[(group >> 18) & 0x3f];
+    id += BASE64URL[(group >> 12) & 0x3f];
+    if (i + 1 < SESSION_ID_BYTES) {
+      id += BASE64URL[(group >> 6) & 0x3f];
+    }
+    if (i + 2 < SESSION_ID_BYTES) {
+      id += BASE64URL[group & 0x3f];
+    }
   }
+  std::memset(entropy_ + entropy_pos_, 0, SESSION_ID_BYTES);
+  entropy_pos_ += SESSION_ID_BYTES;
   return id;
 }
 
+/* getentropy gives at most 256 bytes a call and never blocks once the
+pool is seeded */
+void SessionHandler::fillEntropy(void) {
+  if (getentropy(entropy_, SESSION_ID_BATCH_SIZE) == ERROR<int>()) {
+    throw ResponseException(C500);
+  }
+  entropy_pos_ = 0;
+}
+
 void SessionHandler::createSession(Client *client, std::string &id) {
   const std::string &body = client->getRequest().getBody();
 
   const Session::ValueType &values = parseData(body);
 
   Session *session = new Session(id, values);
-  client->getHttpServer()->addSession(id, session);
+  client->getHttpServer()->addSession(session, Clock::now());
 
   client->setSession(session);
-  client->setSessionTimeout();
+  client->setTimer();
 }
 
 Session::ValueType SessionHandler::parseData(const std::string &data) {
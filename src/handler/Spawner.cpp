@@ -0,0 +1,71 @@
+#include "Spawner.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+
+#include "ProcessTable.hpp"
+#include "constant.hpp"
+
+int Spawner::openPipe(int pipe_fds[2]) {
+  if (pipe(pipe_fds) == ERROR<int>()) {
+    return ERROR<int>();
+  }
+  if (setCloseOnExec(pipe_fds[0]) == ERROR<int>() ||
+      setCloseOnExec(pipe_fds[1]) == ERROR<int>()) {
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    return ERROR<int>();
+  }
+  return 0;
+}
+
+int Spawner::setCloseOnExec(int fd) { return fcntl(fd, F_SETFD, FD_CLOEXEC); }
+
+/* posix_spawn is vfork/clone(CLONE_VM) based, so its cost does not grow
+with the memory the server holds the way fork does */
+pid_t Spawner::spawn(char* const argv[], char* const envp[], int stdin_fd,
+                     int stdout_fd) {
+  posix_spawn_file_actions_t actions;
+  posix_spawnattr_t attr;
+  sigset_t default_signals;
+  sigset_t no_signals;
+  short flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+  pid_t pid;
+
+  if (posix_spawn_file_actions_init(&actions) != 0) {
+    return ERROR<pid_t>();
+  }
+  if (posix_spawnattr_init(&attr) != 0) {
+    posix_spawn_file_actions_destroy(&actions);
+    return ERROR<pid_t>();
+  }
+  posix_spawn_file_actions_adddup2(&actions, stdin_fd, STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, stdout_fd, STDOUT_FILENO);
+
+  /* the server ignores these, a CGI script should not */
+  sigemptyset(&default_signals);
+  sigaddset(&default_signals, SIGPIPE);
+  sigaddset(&default_signals, SIGCHLD);
+  sigaddset(&default_signals, SIGUSR1);
+  sigaddset(&default_signals, SIGTERM);
+  sigaddset(&default_signals, SIGINT);
+  posix_spawnattr_setsigdefault(&attr, &default_signals);
+  sigemptyset(&no_signals);
+  posix_spawnattr_setsigmask(&attr, &no_signals);
+#ifdef POSIX_SPAWN_CLOEXEC_DEFAULT
+  flags |= POSIX_SPAWN_CLOEXEC_DEFAULT;
+#endif
+  posix_spawnattr_setflags(&attr, flags);
+
+  int error = posix_spawn(&pid, argv[0], &actions, &attr, argv, envp);
+
+  posix_spawnattr_destroy(&attr);
+  posix_spawn_file_actions_destroy(&actions);
+  if (error != 0) {
+    return ERROR<pid_t>();
+  }
+  ProcessTable::add(pid, argv[1] ? argv[1] : argv[0]);
+  return pid;
+}
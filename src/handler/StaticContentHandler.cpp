@@ -3,13 +3,113 @@
 struct Response StaticContentHandler::handle(Client *client) {
   struct Response response;
 
+  response.headers["Content-Type"] =
+      (client->isErrorCode() == true)
+          ? "text/html"
+          : MimeTypes::find(findFile(client->getLocation(),
+                                     client->getFullUri()));
+  if (openPrecompressed(client, response) == true ||
+      encodeFile(client, response) == true) {
+    return response;
+  }
   response.body = generateBody(client);
 
-  response.headers["content-length"] = toString(response.body.size());
-
   return response;
 }
 
+/* with gzip_static or brotli_static, a file.br or file.gz the client accepts
+ * is sent as the file body, untouched, instead of the file itself */
+bool StaticContentHandler::openPrecompressed(Client *client,
+                                             struct Response &response) {
+  Location &location = client->getLocation();
+  const std::string &method = client->getRequest().getMethod();
+  if (location.getGzipStatic() == false &&
+      location.getBrotliStatic() == false) {
+    return false;
+  }
+  if (client->isErrorCode() == true ||
+      (method != METHODS[GET] && method != METHODS[HEAD])) {
+    return false;
+  }
+  std::string path = findFile(location, client->getFullUri());
+  if (path.empty() == true) {
+    return false;
+  }
+  response.headers["Vary"] = "Accept-Encoding";
+  const std::string accept_encoding =
+      client->getRequest().getHeader("ACCEPT-ENCODING");
+  if (location.getBrotliStatic() == true &&
+      acceptsEncoding(accept_encoding, "br") == true &&
+      openSibling(path + ".br", response) == true) {
+    response.headers["Content-Encoding"] = "br";
+    return true;
+  }
+  if (location.getGzipStatic() == true &&
+      acceptsEncoding(accept_encoding, "gzip") == true &&
+      openSibling(path + ".gz", response) == true) {
+    response.headers["Content-Encoding"] = "gzip";
+    return true;
+  }
+  return false;
+}
+
+/* a file without a precompressed sibling is encoded once and cached,
+one too large to deflate on the loop is sent as it is */
+bool StaticContentHandler::encodeFile(Client *client,
+                                      struct Response &response) {
+  const std::string &method = client->getRequest().getMethod();
+  if (client->isErrorCode() == true ||
+      (method != METHODS[GET] && method != METHODS[HEAD])) {
+    return false;
+  }
+  std::string path = findFile(client->getLocation(), client->getFullUri());
+  if (path.empty() == true) {
+    return false;
+  }
+  if (Compressor::encodeFile(client, response, path) == true) {
+    return true;
+  }
+  struct stat info;
+  return client->getLocation().getGzip() == true &&
+         stat(path.c_str(), &info) == 0 &&
+         GZIP_FILE_MAX_SIZE < static_cast<std::size_t>(info.st_size) &&
+         openSibling(path, response) == true;
+}
+
+bool StaticContentHandler::openSibling(const std::string &path,
+                                       struct Response &response) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) == -1 || S_ISREG(info.st_mode) == false) {
+    close(fd);
+    return false;
+  }
+  response.file_fd = fd;
+  response.file_offset = 0;
+  response.file_size = info.st_size;
+  return true;
+}
+
+/* the file readPage would serve, or an empty path for none */
+std::string StaticContentHandler::findFile(Location &location,
+                                           const std::string &uri) {
+  if (isDirectory(uri) == false) {
+    return uri;
+  }
+  std::string url = (*uri.rbegin() == '/') ? uri : uri + '/';
+  struct stat info;
+  for (std::size_t i = 0; i < location.getIndex().size(); ++i) {
+    std::string path = url + location.getIndex()[i];
+    if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+      return path;
+    }
+  }
+  return "";
+}
+
 std::string StaticContentHandler::generateBody(Client *client) {
   std::string body;
   std::string uri = client->getFullUri();
@@ -0,0 +1,297 @@
+#include "StatusHandler.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+const double StatusHandler::QUANTILES[] = {0.5, 0.99, 0.999};
+const char *const StatusHandler::QUANTILE_LABELS[] = {"0.5", "0.99", "0.999"};
+
+struct Response StatusHandler::handle(Client *client) {
+  struct Response response;
+
+  if (client->getLocation().getStubStatus() == "prometheus") {
+    response.body = renderPrometheus(client);
+    response.headers["Content-Type"] = "text/plain; version=0.0.4";
+  } else {
+    response.body = renderText(client);
+    response.headers["Content-Type"] = "text/plain";
+  }
+  return response;
+}
+
+/*======================//
+ text
+========================*/
+
+std::string StatusHandler::renderText(Client *client) {
+  const SessionStore &sessions = client->getHttpServer()->getSessions();
+  const ResponseCache::Stats &cache = ResponseCache::getStats();
+  const Compressor::Stats &gzip = Compressor::getStats();
+  std::string body;
+
+  body += "Active connections: " + toString(Metrics::getActive()) + " \n";
+  body += "server accepts handled requests\n";
+  body += " " + toString(Metrics::getAccepted()) + " " +
+          toString(Metrics::getAccepted()) + " " +
+          toString(Metrics::getRequests()) + " \n";
+  body += "Reading: " + toString(Metrics::getReading()) +
+          " Writing: " + toString(Metrics::getWriting()) +
+          " Waiting: " + toString(getWaiting()) + " \n";
+  body += "Bytes: in " + toString(Metrics::getBytesIn()) + " out " +
+          toString(Metrics::getBytesOut()) + "\n";
+  body += "Loop: iterations " + toString(Metrics::getLoops()) + " events " +
+          toString(Metrics::getEvents()) + "\n";
+  body += "CGI: running " + toString(CgiLimiter::runningTotal()) +
+          " queued " + toString(CgiLimiter::queuedTotal()) + " processes " +
+          toString(ProcessTable::size()) + "\n";
+  body += "Sessions: " + toString(sessions.size()) + " of " +
+          toString(sessions.capacity()) + "\n";
+  body += "Cache: hits " + toString(cache.hits) + " misses " +
+          toString(cache.misses) + " ratio " +
+          getRatio(cache.hits, cache.hits + cache.misses) + " entries " +
+          toString(ResponseCache::entries()) + "\n";
+  body += "Gzip: encoded " + toString(gzip.encoded) + " ratio " +
+          getRatio(gzip.bytes_out, gzip.bytes_in) + "\n";
+  for (std::map<std::string, UpstreamGroup *>::const_iterator it =
+           UpstreamGroup::getGroups().begin();
+       it != UpstreamGroup::getGroups().end(); ++it) {
+    body += "Upstream " + it->second->getName() + ": available " +
+            toString(it->second->available(Clock::now())) + " of " +
+            toString(it->second->size()) + "\n";
+  }
+  for (Metrics::StatusType::const_iterator it = Metrics::getStatuses().begin();
+       it != Metrics::getStatuses().end(); ++it) {
+    body += "Status " + it->first + ": " + toString(it->second) + "\n";
+  }
+  for (Metrics::LatencyType::const_iterator it =
+           Metrics::getLatencies().begin();
+       it != Metrics::getLatencies().end(); ++it) {
+    for (std::size_t i = 0; i < Metrics::PHASE_COUNT; ++i) {
+      const Histogram &histogram = it->second[i];
+      body += "Latency " + it->first + " " + Metrics::PHASES[i] + ": p50 " +
+              toString(histogram.quantile(QUANTILES[0])) + " p99 " +
+              toString(histogram.quantile(QUANTILES[1])) + " p999 " +
+              toString(histogram.quantile(QUANTILES[2])) + " us\n";
+    }
+  }
+  return body;
+}
+
+/*======================//
+ prometheus
+========================*/
+
+std::string StatusHandler::renderPrometheus(Client *client) {
+  const SessionStore &sessions = client->getHttpServer()->getSessions();
+  const ResponseCache::Stats &cache = ResponseCache::getStats();
+  const Compressor::Stats &gzip = Compressor::getStats();
+  std::string body;
+
+  appendFamily(body, "webserv_connections", "gauge",
+               "Open client connections by state.");
+  appendSample(body, "webserv_connections", "state=\"reading\"",
+               Metrics::getReading());
+  appendSample(body, "webserv_connections", "state=\"writing\"",
+               Metrics::getWriting());
+  appendSample(body, "webserv_connections", "state=\"waiting\"",
+               getWaiting());
+  appendFamily(body, "webserv_connections_accepted_total", "counter",
+               "Accepted client connections.");
+  appendSample(body, "webserv_connections_accepted_total", "",
+               Metrics::getAccepted());
+  appendFamily(body, "webserv_requests_total", "counter",
+               "Parsed requests.");
+  appendSample(body, "webserv_requests_total", "", Metrics::getRequests());
+  appendFamily(body, "webserv_responses_total", "counter",
+               "Responses by status code.");
+  for (Metrics::StatusType::const_iterator it = Metrics::getStatuses().begin();
+       it != Metrics::getStatuses().end(); ++it) {
+    appendSample(body, "webserv_responses_total", "code=\"" + it->first + "\"",
+                 it->second);
+  }
+  appendFamily(body, "webserv_bytes_total", "counter",
+               "Bytes read from and written to clients.");
+  appendSample(body, "webserv_bytes_total", "direction=\"in\"",
+               Metrics::getBytesIn());
+  appendSample(body, "webserv_bytes_total", "direction=\"out\"",
+               Metrics::getBytesOut());
+  appendFamily(body, "webserv_loop_iterations_total", "counter",
+               "Returns from kevent.");
+  appendSample(body, "webserv_loop_iterations_total", "", Metrics::getLoops());
+  appendFamily(body, "webserv_loop_events_total", "counter",
+               "Events handled by the loop.");
+  appendSample(body, "webserv_loop_events_total", "", Metrics::getEvents());
+
+  appendFamily(body, "webserv_cgi_running", "gauge",
+               "CGI scripts holding a limiter slot.");
+  appendSample(body, "webserv_cgi_running", "", CgiLimiter::runningTotal());
+  appendFamily(body, "webserv_cgi_queued", "gauge",
+               "Requests waiting for a CGI slot.");
+  appendSample(body, "webserv_cgi_queued", "", CgiLimiter::queuedTotal());
+  appendFamily(body, "webserv_processes", "gauge",
+               "Child processes not reaped yet.");
+  appendSample(body, "webserv_processes", "", ProcessTable::size());
+  appendFamily(body, "webserv_cgi_runs_total", "counter",
+               "Finished CGI processes by script.");
+  for (ProcessTable::StatsType::const_iterator it =
+           ProcessTable::getStats().begin();
+       it != ProcessTable::getStats().end(); ++it) {
+    appendSample(body, "webserv_cgi_runs_total", toLabel("script", it->first),
+                 it->second.runs);
+  }
+  appendFamily(body, "webserv_cgi_failures_total", "counter",
+               "CGI processes that exited abnormally, by script.");
+  for (ProcessTable::StatsType::const_iterator it =
+           ProcessTable::getStats().begin();
+       it != ProcessTable::getStats().end(); ++it) {
+    appendSample(body, "webserv_cgi_failures_total",
+                 toLabel("script", it->first), it->second.failures);
+  }
+
+  appendFamily(body, "webserv_sessions", "gauge",
+               "Sessions of the virtual server.");
+  appendSample(body, "webserv_sessions", "", sessions.size());
+  appendFamily(body, "webserv_sessions_capacity", "gauge",
+               "Most sessions the virtual server keeps.");
+  appendSample(body, "webserv_sessions_capacity", "", sessions.capacity());
+  appendFamily(body, "webserv_sessions_removed_total", "counter",
+               "Sessions dropped by reason.");
+  appendSample(body, "webserv_sessions_removed_total", "reason=\"expired\"",
+               sessions.getStats().expired);
+  appendSample(body, "webserv_sessions_removed_total", "reason=\"evicted\"",
+               sessions.getStats().evicted);
+
+  appendFamily(body, "webserv_cache_lookups_total", "counter",
+               "Response cache lookups by result.");
+  appendSample(body, "webserv_cache_lookups_total", "result=\"hit\"",
+               cache.hits);
+  appendSample(body, "webserv_cache_lookups_total", "result=\"miss\"",
+               cache.misses);
+  appendSample(body, "webserv_cache_lookups_total", "result=\"coalesced\"",
+               cache.coalesced);
+  appendFamily(body, "webserv_cache_bytes", "gauge",
+               "Bytes held by the response cache.");
+  appendSample(body, "webserv_cache_bytes", "", ResponseCache::size());
+  appendFamily(body, "webserv_disk_cache_lookups_total", "counter",
+               "Disk cache lookups by path and result.");
+  for (std::map<std::string, DiskCache *>::const_iterator it =
+           DiskCache::getCaches().begin();
+       it != DiskCache::getCaches().end(); ++it) {
+    const std::string path = toLabel("path", it->first);
+    appendSample(body, "webserv_disk_cache_lookups_total",
+                 path + ",result=\"hit\"", it->second->getStats().hits);
+    appendSample(body, "webserv_disk_cache_lookups_total",
+                 path + ",result=\"miss\"", it->second->getStats().misses);
+  }
+
+  appendFamily(body, "webserv_gzip_bytes_total", "counter",
+               "Bytes through the compressor.");
+  appendSample(body, "webserv_gzip_bytes_total", "direction=\"in\"",
+               gzip.bytes_in);
+  appendSample(body, "webserv_gzip_bytes_total", "direction=\"out\"",
+               gzip.bytes_out);
+
+  appendFamily(body, "webserv_upstream_available", "gauge",
+               "Servers of an upstream group a request may go to.");
+  for (std::map<std::string, UpstreamGroup *>::const_iterator it =
+           UpstreamGroup::getGroups().begin();
+       it != UpstreamGroup::getGroups().end(); ++it) {
+    appendSample(body, "webserv_upstream_available",
+                 toLabel("group", it->second->getName()),
+                 it->second->available(Clock::now()));
+  }
+  appendLatencies(body);
+  return body;
+}
+
+/* a summary per location and phase */
+void StatusHandler::appendLatencies(std::string &body) {
+  const std::string name = "webserv_phase_duration_seconds";
+
+  appendFamily(body, name, "summary", "Time requests spent in each phase.");
+  for (Metrics::LatencyType::const_iterator it =
+           Metrics::getLatencies().begin();
+       it != Metrics::getLatencies().end(); ++it) {
+    for (std::size_t i = 0; i < Metrics::PHASE_COUNT; ++i) {
+      const Histogram &histogram = it->second[i];
+      const std::string labels = toLabel("location", it->first) + "," +
+                                 toLabel("phase", Metrics::PHASES[i]);
+      for (std::size_t q = 0; q < QUANTILE_COUNT; ++q) {
+        appendSample(body, name,
+                     labels + ",quantile=\"" + QUANTILE_LABELS[q] + "\"",
+                     toSeconds(histogram.quantile(QUANTILES[q])));
+      }
+      appendSample(body, name + "_sum", labels, toSeconds(histogram.sum()));
+      appendSample(body, name + "_count", labels,
+                   static_cast<std::size_t>(histogram.count()));
+    }
+  }
+}
+
+void StatusHandler::appendFamily(std::string &body, const std::string &name,
+                                 const std::string &type,
+                                 const std::string &help) {
+  body += "# HELP " + name + " " + help + "\n";
+  body += "# TYPE " + name + " " + type + "\n";
+}
+
+void StatusHandler::appendSample(std::string &body, const std::string &name,
+                                 const std::string &labels,
+                                 std::size_t value) {
+  appendSample(body, name, labels, toString(value));
+}
+
+void StatusHandler::appendSample(std::string &body, const std::string &name,
+                                 const std::string &labels,
+                                 const std::string &value) {
+  body += name;
+  if (labels.empty() == false) {
+    body += "{" + labels + "}";
+  }
+  body += " " + value + "\n";
+}
+
+/*======================//
+ utils
+========================*/
+
+/* name="value" with the backslash, quote and newline of value escaped */
+std::string StatusHandler::toLabel(const std::string &name,
+                                   const std::string &value) {
+  std::string label = name + "=\"";
+
+  for (std::size_t i = 0; i < value.size(); ++i) {
+    if (value[i] == '\\' || value[i] == '"') {
+      label += '\\';
+      label += value[i];
+    } else if (value[i] == '\n') {
+      label += "\\n";
+    } else {
+      label += value[i];
+    }
+  }
+  return label + "\"";
+}
+
+/* connections open between two requests */
+std::size_t StatusHandler::getWaiting(void) {
+  std::size_t busy = Metrics::getReading() + Metrics::getWriting();
+  std::size_t active = Metrics::getActive();
+
+  return (busy < active) ? active - busy : 0;
+}
+
+std::string StatusHandler::getRatio(std::size_t part, std::size_t whole) {
+  std::ostringstream ratio;
+
+  ratio << std::fixed << std::setprecision(2)
+        << ((whole == 0) ? 0.0 : static_cast<double>(part) / whole);
+  return ratio.str();
+}
+
+std::string StatusHandler::toSeconds(uint64_t microseconds) {
+  std::ostringstream seconds;
+
+  seconds << std::fixed << std::setprecision(6) << microseconds / 1e6;
+  return seconds.str();
+}
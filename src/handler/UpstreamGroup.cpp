@@ -0,0 +1,333 @@
+#include "UpstreamGroup.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "Client.hpp"
+#include "ServerManager.hpp"
+#include "utility.hpp"
+
+std::map<std::string, UpstreamGroup*> UpstreamGroup::groups_;
+
+UpstreamGroup::UpstreamGroup(const UpstreamBlock& block)
+    : name_(block.name),
+      balance_(block.balance),
+      check_interval_(block.check_interval),
+      check_uri_(block.check_uri),
+      next_(0) {
+  for (std::vector<UpstreamServer>::const_iterator it = block.servers.begin();
+       it != block.servers.end(); ++it) {
+    Peer peer;
+    peer.pool = new UpstreamPool(it->host, it->port);
+    peer.weight = it->weight;
+    peer.max_fails = it->max_fails;
+    peer.fail_timeout = it->fail_timeout;
+    peer.current_weight = 0;
+    peer.fails = 0;
+    peer.failed_at = 0;
+    peer.is_healthy = true;
+    peer.probe_fd = DEFAULT_FD;
+    peer.probed_at = 0;
+    peers_.push_back(peer);
+  }
+  /* each server owns weight * UPSTREAM_VIRTUAL_NODES points of the ring */
+  for (std::size_t i = 0; i < peers_.size(); ++i) {
+    const std::string address =
+        peers_[i].pool->getHost() + ":" + peers_[i].pool->getPort();
+    for (std::size_t node = 0;
+         node < peers_[i].weight * UPSTREAM_VIRTUAL_NODES; ++node) {
+      ring_.push_back(std::make_pair(fnv1a(address + "-" + toString(node)), i));
+    }
+  }
+  std::sort(ring_.begin(), ring_.end());
+}
+
+UpstreamGroup::~UpstreamGroup() {
+  for (std::size_t i = 0; i < peers_.size(); ++i) {
+    if (peers_[i].probe_fd != DEFAULT_FD) {
+      close(peers_[i].probe_fd);
+    }
+    delete peers_[i].pool;
+  }
+}
+
+/*======================//
+ balance
+========================*/
+
+/* the server the next request goes to, NULL if none is available */
+UpstreamPool* UpstreamGroup::select(const Client* client, std::time_t now) {
+  Peer* peer = NULL;
+
+  switch (balance_) {
+    case B_ROUND_ROBIN:
+      peer = selectRoundRobin(now);
+      break;
+    case B_LEAST_CONN:
+      peer = selectLeastConn(now);
+      break;
+    case B_HASH_URI:
+      peer = selectHash(client->getRequest().getUri(), now);
+      break;
+    case B_HASH_SESSION: {
+      std::string key = client->getRequest().getCookie(SESSION_ID_FIELD);
+      if (key.empty() == true) {
+        key = client->getAddr().getIP();
+      }
+      peer = selectHash(key, now);
+    }
+  }
+  return (peer == NULL) ? NULL : peer->pool;
+}
+
+/* smooth weighted round robin: every available server gains its
+weight, the leader is picked and pays back the total */
+UpstreamGroup::Peer* UpstreamGroup::selectRoundRobin(std::time_t now) {
+  Peer* best = NULL;
+  long total = 0;
+
+  for (std::size_t i = 0; i < peers_.size(); ++i) {
+    if (isAvailable(peers_[i], now) == false) {
+      continue;
+    }
+    peers_[i].current_weight += peers_[i].weight;
+    total += peers_[i].weight;
+    if (best == NULL || best->current_weight < peers_[i].current_weight) {
+      best = &peers_[i];
+    }
+  }
+  if (best != NULL) {
+    best->current_weight -= total;
+  }
+  return best;
+}
+
+/* fewest busy connections relative to weight, ties are rotated */
+UpstreamGroup::Peer* UpstreamGroup::selectLeastConn(std::time_t now) {
+  Peer* best = NULL;
+
+  for (std::size_t count = 0; count < peers_.size(); ++count) {
+    Peer& peer = peers_[(next_ + count) % peers_.size()];
+    if (isAvailable(peer, now) == false) {
+      continue;
+    }
+    if (best == NULL || peer.pool->busy() * best->weight <
+                            best->pool->busy() * peer.weight) {
+      best = &peer;
+    }
+  }
+  next_ = (next_ + 1) % peers_.size();
+  return best;
+}
+
+/* the first available server clockwise from the key on the ring */
+UpstreamGroup::Peer* UpstreamGroup::selectHash(const std::string& key,
+                                               std::time_t now) {
+  RingType::const_iterator it = std::lower_bound(
+      ring_.begin(), ring_.end(), std::make_pair(fnv1a(key), std::size_t(0)));
+
+  for (std::size_t count = 0; count < ring_.size(); ++count, ++it) {
+    if (it == ring_.end()) {
+      it = ring_.begin();
+    }
+    if (isAvailable(peers_[it->second], now) == true) {
+      return &peers_[it->second];
+    }
+  }
+  return NULL;
+}
+
+/*======================//
+ passive check
+========================*/
+
+/* a connection or response failed: after max_fails of them in a row
+the server is skipped for fail_timeout seconds */
+void UpstreamGroup::fail(UpstreamPool* pool, std::time_t now) {
+  Peer* peer = findPeer(pool);
+
+  if (peer == NULL) {
+    return;
+  }
+  if (peer->failed_at + peer->fail_timeout <= now) {
+    peer->fails = 0;
+  }
+  peer->fails += 1;
+  peer->failed_at = now;
+}
+
+void UpstreamGroup::succeed(UpstreamPool* pool) {
+  Peer* peer = findPeer(pool);
+
+  if (peer != NULL) {
+    peer->fails = 0;
+  }
+}
+
+/* max_fails 0 turns the passive check off */
+bool UpstreamGroup::isAvailable(const Peer& peer, std::time_t now) const {
+  if (peer.is_healthy == false) {
+    return false;
+  }
+  return (peer.max_fails == 0 || peer.fails < peer.max_fails ||
+          peer.failed_at + peer.fail_timeout <= now);
+}
+
+/*======================//
+ active check
+========================*/
+
+/* close idle connections and probe every server once per interval.
+a probe still running after a whole interval counts as failed */
+void UpstreamGroup::maintain(ServerManager* manager, std::time_t now) {
+  for (std::size_t i = 0; i < peers_.size(); ++i) {
+    Peer& peer = peers_[i];
+
+    peer.pool->maintain(now);
+    if (check_interval_ == 0 || now - peer.probed_at < check_interval_) {
+      continue;
+    }
+    if (peer.probe_fd != DEFAULT_FD) {
+      endProbe(manager, peer, false);
+    }
+    startProbe(manager, peer, now);
+  }
+}
+
+/* a probe is a plain GET of check_uri, healthy on a 2xx or 3xx */
+void UpstreamGroup::startProbe(ServerManager* manager, Peer& peer,
+                               std::time_t now) {
+  peer.probed_at = now;
+  peer.probe_fd = peer.pool->connect();
+  if (peer.probe_fd == ERROR<int>()) {
+    peer.probe_fd = DEFAULT_FD;
+    peer.is_healthy = false;
+    return;
+  }
+  manager->watchProbe(peer.probe_fd, this);
+  manager->createEvent(peer.probe_fd, EVFILT_WRITE, EV_ADD | EV_ONESHOT, 0, 0,
+                       NULL);
+}
+
+void UpstreamGroup::handleProbe(ServerManager* manager,
+                                const struct kevent& event) {
+  Peer* peer = findPeer(static_cast<int>(event.ident));
+  if (peer == NULL) {
+    return;
+  }
+
+  if (event.filter == EVFILT_WRITE) {
+    const std::string request = "GET " + check_uri_ + " HTTP/1.0" + CRLF +
+                                "Host: " + peer->pool->getHost() + CRLF + CRLF;
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(peer->probe_fd, SOL_SOCKET, SO_ERROR, &error, &length) ==
+            ERROR<int>() ||
+        error != 0 ||
+        send(peer->probe_fd, request.c_str(), request.size(), 0) !=
+            static_cast<ssize_t>(request.size())) {
+      endProbe(manager, *peer, false);
+      return;
+    }
+    manager->createEvent(peer->probe_fd, EVFILT_READ, EV_ADD | EV_ONESHOT, 0,
+                         0, NULL);
+    return;
+  }
+  char buffer[16];
+  ssize_t read_bytes = recv(peer->probe_fd, buffer, sizeof(buffer), 0);
+  const std::string status_line =
+      (read_bytes <= 0) ? "" : std::string(buffer, read_bytes);
+  endProbe(manager, *peer,
+           status_line.compare(0, 7, "HTTP/1.") == 0 &&
+               status_line.size() > 9 &&
+               (status_line[9] == '2' || status_line[9] == '3'));
+}
+
+/* a server coming back starts with a clean failure count */
+void UpstreamGroup::endProbe(ServerManager* manager, Peer& peer,
+                             bool is_healthy) {
+  manager->unwatchProbe(peer.probe_fd);
+  close(peer.probe_fd);
+  peer.probe_fd = DEFAULT_FD;
+  if (is_healthy == true && peer.is_healthy == false) {
+    peer.fails = 0;
+  }
+  peer.is_healthy = is_healthy;
+}
+
+/*======================//
+ registry
+========================*/
+
+/* groups declared by upstream blocks */
+void UpstreamGroup::define(const UpstreamBlock& block) {
+  groups_[block.name] = new UpstreamGroup(block);
+}
+
+/* the upstream named host, or the group of the single server
+host:port which is made on first use */
+UpstreamGroup* UpstreamGroup::find(const std::string& host,
+                                   const std::string& port) {
+  std::map<std::string, UpstreamGroup*>::iterator group = groups_.find(host);
+  if (group != groups_.end()) {
+    return group->second;
+  }
+  const std::string address = host + ":" + port;
+  group = groups_.find(address);
+  if (group != groups_.end()) {
+    return group->second;
+  }
+  UpstreamBlock block;
+  block.name = address;
+  block.servers.push_back(UpstreamServer(address));
+  return groups_[address] = new UpstreamGroup(block);
+}
+
+void UpstreamGroup::maintainAll(ServerManager* manager, std::time_t now) {
+  for (std::map<std::string, UpstreamGroup*>::iterator it = groups_.begin();
+       it != groups_.end(); ++it) {
+    it->second->maintain(manager, now);
+  }
+}
+
+const std::map<std::string, UpstreamGroup*>& UpstreamGroup::getGroups(void) {
+  return groups_;
+}
+
+/*======================//
+ utils
+========================*/
+
+const std::string& UpstreamGroup::getName(void) const { return name_; }
+std::size_t UpstreamGroup::size(void) const { return peers_.size(); }
+
+/* servers a request could be sent to right now */
+std::size_t UpstreamGroup::available(std::time_t now) const {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < peers_.size(); ++i) {
+    if (isAvailable(peers_[i], now) == true) {
+      count += 1;
+    }
+  }
+  return count;
+}
+
+UpstreamGroup::Peer* UpstreamGroup::findPeer(const UpstreamPool* pool) {
+  for (std::size_t i = 0; i < peers_.size(); ++i) {
+    if (peers_[i].pool == pool) {
+      return &peers_[i];
+    }
+  }
+  return NULL;
+}
+
+UpstreamGroup::Peer* UpstreamGroup::findPeer(int probe_fd) {
+  for (std::size_t i = 0; i < peers_.size(); ++i) {
+    if (peers_[i].probe_fd == probe_fd) {
+      return &peers_[i];
+    }
+  }
+  return NULL;
+}
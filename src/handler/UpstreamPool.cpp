@@ -0,0 +1,133 @@
+#include "UpstreamPool.hpp"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "Error.hpp"
+#include "Spawner.hpp"
+#include "constant.hpp"
+
+UpstreamPool::UpstreamPool(const std::string& host, const std::string& port)
+    : host_(host), port_(port), busy_(0) {
+  struct addrinfo hints, *addr_info;
+
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+
+  int result = getaddrinfo(host.c_str(), port.c_str(), &hints, &addr_info);
+  if (result != 0) {
+    Error::log(Error::INFO[ETOKEN], host + ":" + port, EXIT_FAILURE);
+  }
+  std::memcpy(&address_, addr_info->ai_addr, sizeof(address_));
+  freeaddrinfo(addr_info);
+}
+
+UpstreamPool::~UpstreamPool() {
+  for (ConnectionType::iterator it = idle_.begin(); it != idle_.end(); ++it) {
+    close(it->fd);
+  }
+}
+
+/*======================//
+ dispatch
+========================*/
+
+/* an idle connection if one is still open, otherwise a new one whose
+connect completes in the background. -1 if no socket can be made */
+int UpstreamPool::acquire(bool& is_reused) {
+  while (idle_.empty() == false) {
+    int fd = idle_.back().fd;
+    idle_.pop_back();
+    if (isUsable(fd) == true) {
+      is_reused = true;
+      busy_ += 1;
+      return fd;
+    }
+    close(fd);
+  }
+  is_reused = false;
+  int fd = connect();
+  if (fd != ERROR<int>()) {
+    busy_ += 1;
+  }
+  return fd;
+}
+
+/* park a connection whose response ended cleanly */
+void UpstreamPool::release(int fd, std::time_t now) {
+  busy_ -= 1;
+  if (PROXY_KEEPALIVE <= idle_.size()) {
+    close(fd);
+    return;
+  }
+  Connection connection;
+  connection.fd = fd;
+  connection.since = now;
+  idle_.push_back(connection);
+}
+
+/* close a connection that can not be reused */
+void UpstreamPool::discard(int fd) {
+  busy_ -= 1;
+  close(fd);
+}
+
+/*======================//
+ supervise
+========================*/
+
+/* close connections idle too long or closed by the upstream */
+void UpstreamPool::maintain(std::time_t now) {
+  for (ConnectionType::iterator it = idle_.begin(); it != idle_.end();) {
+    if (PROXY_KEEPALIVE_TIMEOUT <= now - it->since ||
+        isUsable(it->fd) == false) {
+      close(it->fd);
+      it = idle_.erase(it);
+      continue;
+    }
+    ++it;
+  }
+}
+
+const std::string& UpstreamPool::getHost(void) const { return host_; }
+const std::string& UpstreamPool::getPort(void) const { return port_; }
+std::size_t UpstreamPool::idle(void) const { return idle_.size(); }
+std::size_t UpstreamPool::busy(void) const { return busy_; }
+
+/*======================//
+ utils
+========================*/
+
+int UpstreamPool::connect(void) const {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd == ERROR<int>()) {
+    return ERROR<int>();
+  }
+  if (Spawner::setCloseOnExec(fd) == ERROR<int>() ||
+      fcntl(fd, F_SETFL, O_NONBLOCK) == ERROR<int>()) {
+    close(fd);
+    return ERROR<int>();
+  }
+  if (::connect(fd, reinterpret_cast<const struct sockaddr*>(&address_),
+                sizeof(address_)) == ERROR<int>() &&
+      errno != EINPROGRESS) {
+    close(fd);
+    return ERROR<int>();
+  }
+  return fd;
+}
+
+/* an idle connection must have nothing to read: data is a protocol
+error and EOF means the upstream closed it */
+bool UpstreamPool::isUsable(int fd) {
+  char byte;
+
+  ssize_t peeked = recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+  return (peeked == ERROR<ssize_t>() && errno == EAGAIN);
+}
@@ -80,6 +80,10 @@ std::string HttpRequest::getHeader(const std::string& key) const {
   return headers_.at(key).front();
 }
 
+const HttpRequest::headers_type& HttpRequest::getHeaders(void) const {
+  return headers_;
+}
+
 std::string HttpRequest::getCookie(const std::string& name) const {
   if (cookie_.find(name) == cookie_.end()) {
     return "";
@@ -151,6 +155,12 @@ bool HttpRequest::isHeaderSet(void) const { return is_header_set_; }
 
 bool HttpRequest::isCompleted(void) const { return is_completed_request_; }
 
+/* some of the request arrived */
+bool HttpRequest::isStarted(void) const {
+  return (buffer_.empty() == false || method_.empty() == false ||
+          is_completed_request_ == true);
+}
+
 void HttpRequest::clear(void) {
   *this = HttpRequest();
   buffer_.clear();
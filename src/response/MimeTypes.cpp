@@ -0,0 +1,32 @@
+#include "MimeTypes.hpp"
+
+#include <algorithm>
+
+#include "utility.hpp"
+
+std::vector<MimeTypes::Type> MimeTypes::types_;
+
+/* the map is ordered by extension already */
+void MimeTypes::define(const std::map<std::string, std::string>& types) {
+  types_.assign(types.begin(), types.end());
+}
+
+const std::string& MimeTypes::find(const std::string& path) {
+  static const std::string default_type = DEFAULT_TYPE;
+
+  std::size_t dot = path.rfind('.');
+  if (dot == std::string::npos || path.find('/', dot) != std::string::npos) {
+    return default_type;
+  }
+  const std::string extension = toLower(path.substr(dot + 1));
+  std::vector<Type>::const_iterator type =
+      std::lower_bound(types_.begin(), types_.end(), extension, compare);
+  if (type == types_.end() || type->first != extension) {
+    return default_type;
+  }
+  return type->second;
+}
+
+bool MimeTypes::compare(const Type& type, const std::string& extension) {
+  return type.first < extension;
+}
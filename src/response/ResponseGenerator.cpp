@@ -3,6 +3,8 @@
 std::string &ResponseGenerator::generateResponse(
     Client &client, struct Response &response_dummy) {
   std::string &response = client.getResponse();
+  response.reserve(response.size() + HEADER_RESERVE_SIZE +
+                   response_dummy.body.size());
   generateStatusLine(response, client, response_dummy);
   generateHeader(response, client, response_dummy);
   if (client.getRequest().getMethod() == METHODS[HEAD]) {
@@ -16,20 +18,22 @@ std::string &ResponseGenerator::generateResponse(
 void ResponseGenerator::generateStatusLine(std::string &response,
                                            Client &client,
                                            struct Response &response_dummy) {
-  int status = client.getStatus();
-
-  response += "HTTP/1.1 ";
-
   std::map<std::string, std::string>::iterator status_header =
       response_dummy.headers.find("Status");
   if (status_header != response_dummy.headers.end()) {
-    response_dummy.headers.erase("Status");
-    response += status_header->second + CRLF;
+    const std::string code = status_header->second.substr(0, 3);
+    Metrics::countStatus(code);
+    client.setStatusCode(code);
+    response += "HTTP/1.1 ";
+    response += status_header->second;
+    response += CRLF;
+    response_dummy.headers.erase(status_header);
     return;
   }
 
-  response += ResponseStatus::CODES[status] + " " +
-              ResponseStatus::REASONS[status] + CRLF;
+  Metrics::countStatus(ResponseStatus::CODES[client.getStatus()]);
+  client.setStatusCode(ResponseStatus::CODES[client.getStatus()]);
+  response += ResponseStatus::LINES[client.getStatus()];
 }
 
 /*===============================
@@ -43,45 +47,77 @@ void ResponseGenerator::generateHeader(std::string &response, Client &client,
   const std::map<std::string, std::string> &headers = response_dummy.headers;
   for (std::map<std::string, std::string>::const_iterator it = headers.begin();
        it != headers.end(); it++) {
-    response += it->first + " : ";
-    response += it->second + CRLF;
+    response += it->first;
+    response += ": ";
+    response += it->second;
+    response += CRLF;
+  }
+  for (std::vector<std::string>::const_iterator it =
+           response_dummy.cookies.begin();
+       it != response_dummy.cookies.end(); ++it) {
+    response += "Set-Cookie: ";
+    response += *it;
+    response += CRLF;
   }
   response += CRLF;
 }
 
 void ResponseGenerator::generateGeneralHeader(std::string &response,
                                               Client &client) {
-  response += getConnectionHeader(client) + CRLF;
-  response += getDateHeader() + CRLF;
-  response += "Cache-Control: no-cache, no-store, must-revalidate" + CRLF;
+  appendConnectionHeader(response, client);
+  response += "Date: ";
+  response += Clock::getHttpDate();
+  response += CRLF;
 }
 
 void ResponseGenerator::generateEntityHeader(std::string &response,
                                              Client &client,
                                              struct Response &response_dummy) {
-  response += "Server: Webserv" + CRLF;
-  response +=
-      "Allow: " + join(client.getLocation().getAllowedMethods(), ", ") + CRLF;
-  response += "Content-Type: text/html" + CRLF;
-  response += "Content-Length: " + toString(response_dummy.body.size()) + CRLF;
+  static const std::string retry_after =
+      "Retry-After: " + toString(CGI_RETRY_AFTER) + CRLF;
+  static const std::string content_type = "Content-Type: text/html" + CRLF;
+  static const std::string cache_control =
+      "Cache-Control: no-cache, no-store, must-revalidate" + CRLF;
+
+  response += client.getLocation().getHeaderBlock();
+  /* a CGI or an upstream may decide how its response is cached */
+  if (ResponseStream::hasHeader(response_dummy.headers, "Cache-Control") ==
+      false) {
+    response += cache_control;
+  }
+  if (client.getStatus() == C503) {
+    response += retry_after;
+  }
+  if (ResponseStream::hasHeader(response_dummy.headers, "Content-Type") ==
+      false) {
+    response += content_type;
+  }
+  if (response_dummy.is_streamed == false) {
+    response += "Content-Length: ";
+    response += toString(response_dummy.body.size() + response_dummy.file_size);
+    response += CRLF;
+  }
 }
 
 /*============================
   create header field
 ============================*/
 
-std::string ResponseGenerator::getConnectionHeader(Client &client) {
-  const std::string header_name = "Connection";
+void ResponseGenerator::appendConnectionHeader(std::string &response,
+                                               Client &client) {
+  static const std::string close = "Connection: close" + CRLF;
+  static const std::string keep_alive = "Connection: keep-alive" + CRLF;
+
   if (client.isErrorCode() == true) {
-    return (header_name + ": close");
+    response += close;
+    return;
   }
-  if (client.getRequest().getHeader("CONNECTION").empty() == false) {
-    return (header_name + " : " + client.getRequest().getHeader("CONNECTION"));
+  const std::string &connection = client.getRequest().getHeader("CONNECTION");
+  if (connection.empty() == false) {
+    response += "Connection: ";
+    response += connection;
+    response += CRLF;
+    return;
   }
-  return (header_name + " : " + "keep-alive");
-}
-
-std::string ResponseGenerator::getDateHeader(void) {
-  const std::string header_name = "Date";
-  return (header_name + " : " + formatTime("%a, %d %b %Y %H:%M:%S GMT"));
+  response += keep_alive;
 }
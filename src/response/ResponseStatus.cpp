@@ -2,7 +2,7 @@
 
 const std::string ResponseStatus::CODES[] = {
     "200", "201", "204", "303", "400", "403", "404",
-    "405", "411", "413", "500", "501", "504", "505",
+    "405", "411", "413", "500", "501", "502", "503", "504", "505",
 };
 
 const std::string ResponseStatus::REASONS[] = {
@@ -18,6 +18,22 @@ const std::string ResponseStatus::REASONS[] = {
     "Payload Too Large",           // 413
     "Internal Server Error",       // 500
     "Not Implement",               // 501
+    "Bad Gateway",                 // 502
+    "Service Unavailable",         // 503
     "Gateway Timeout",             // 504
     "HTTP Version Not Supported",  // 505
 };
+
+/* status lines ready to be copied into a response */
+const std::vector<std::string> ResponseStatus::LINES =
+    ResponseStatus::makeLines();
+
+std::vector<std::string> ResponseStatus::makeLines(void) {
+  const std::size_t count = sizeof(CODES) / sizeof(CODES[0]);
+  std::vector<std::string> lines;
+
+  for (std::size_t i = 0; i < count; ++i) {
+    lines.push_back("HTTP/1.1 " + CODES[i] + " " + REASONS[i] + "\r\n");
+  }
+  return lines;
+}
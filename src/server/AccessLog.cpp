@@ -0,0 +1,361 @@
+#include "AccessLog.hpp"
+
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+#include "Client.hpp"
+#include "Error.hpp"
+#include "utility.hpp"
+
+const char* const AccessLog::VARIABLES[] = {
+    "",                // V_LITERAL
+    "remote_addr",     // V_REMOTE_ADDR
+    "time_local",      // V_TIME_LOCAL
+    "request",         // V_REQUEST
+    "request_method",  // V_REQUEST_METHOD
+    "request_uri",     // V_REQUEST_URI
+    "status",          // V_STATUS
+    "bytes_sent",      // V_BYTES_SENT
+    "request_time",    // V_REQUEST_TIME
+    "host",            // V_HOST
+};
+const char* const AccessLog::HANDLERS[] = {
+    "static",  // H_STATIC
+    "cgi",     // H_CGI
+    "proxy",   // H_PROXY
+};
+const std::string AccessLog::HTTP_PREFIX = "http_";
+
+AccessLog::AccessLog() : mode_(M_TEXT), file_(NULL) {}
+
+AccessLog::AccessLog(const std::string& path, const std::string& format)
+    : mode_(M_TEXT), file_(NULL) {
+  if (path.empty() == true) {
+    return;
+  }
+  if (format == ACCESS_LOG_JSON) {
+    mode_ = M_JSON;
+  } else if (format == ACCESS_LOG_BINARY) {
+    mode_ = M_BINARY;
+  } else {
+    compile(format);
+  }
+  file_ = LogFile::open(path);
+}
+
+AccessLog::AccessLog(const AccessLog& origin)
+    : mode_(origin.mode_), file_(origin.file_), tokens_(origin.tokens_) {}
+
+AccessLog& AccessLog::operator=(const AccessLog& origin) {
+  if (this != &origin) {
+    mode_ = origin.mode_;
+    file_ = origin.file_;
+    tokens_ = origin.tokens_;
+  }
+  return *this;
+}
+
+AccessLog::~AccessLog() {}
+
+void AccessLog::write(const Client& client) const {
+  if (file_ == NULL) {
+    return;
+  }
+  switch (mode_) {
+    case M_TEXT:
+      file_->append(renderText(client));
+      break;
+    case M_JSON:
+      file_->append(renderJson(client));
+      break;
+    case M_BINARY:
+      file_->append(renderBinary(client));
+      break;
+  }
+}
+
+/*======================//
+ format
+========================*/
+
+/* a variable is "$" followed by lowercase letters, digits and "_" */
+void AccessLog::compile(const std::string& format) {
+  std::size_t pos = 0;
+
+  while (pos < format.size()) {
+    std::size_t dollar = format.find('$', pos);
+    if (dollar != pos) {
+      tokens_.push_back(Token(V_LITERAL, format.substr(pos, dollar - pos)));
+      if (dollar == std::string::npos) {
+        break;
+      }
+    }
+    std::size_t end = dollar + 1;
+    while (end < format.size() &&
+           (std::islower(format[end]) || std::isdigit(format[end]) ||
+            format[end] == '_')) {
+      ++end;
+    }
+    addVariable(format.substr(dollar + 1, end - dollar - 1));
+    pos = end;
+  }
+}
+
+void AccessLog::addVariable(const std::string& name) {
+  if (name.size() > HTTP_PREFIX.size() &&
+      name.compare(0, HTTP_PREFIX.size(), HTTP_PREFIX) == 0) {
+    std::string header = name.substr(HTTP_PREFIX.size());
+    for (std::size_t i = 0; i < header.size(); ++i) {
+      header[i] = (header[i] == '_') ? '-' : std::toupper(header[i]);
+    }
+    tokens_.push_back(Token(V_HTTP, header));
+    return;
+  }
+  for (int i = V_REMOTE_ADDR; i < V_HTTP; ++i) {
+    if (name == VARIABLES[i]) {
+      tokens_.push_back(Token(static_cast<Variable>(i), name));
+      return;
+    }
+  }
+  Error::log(Error::INFO[ETOKEN], "$" + name, EXIT_FAILURE);
+}
+
+/*======================//
+ variables
+========================*/
+
+std::string AccessLog::renderText(const Client& client) const {
+  std::string line;
+
+  for (std::vector<Token>::const_iterator it = tokens_.begin();
+       it != tokens_.end(); ++it) {
+    line += render(*it, client);
+  }
+  return line + "\n";
+}
+
+/* an empty value is logged as "-" */
+std::string AccessLog::render(const Token& token, const Client& client) {
+  const HttpRequest& request = client.getRequest();
+  std::string value;
+
+  switch (token.variable) {
+    case V_LITERAL:
+      return token.text;
+    case V_REMOTE_ADDR:
+      value = client.getAddr().getIP();
+      break;
+    case V_TIME_LOCAL:
+      return Clock::getLogDate();
+    case V_REQUEST:
+      if (request.getMethod().empty() == false) {
+        value = request.getMethod() + " " + request.getUri();
+        if (request.getQueryString().empty() == false) {
+          value += "?" + request.getQueryString();
+        }
+        value += " HTTP/1.1";
+      }
+      break;
+    case V_REQUEST_METHOD:
+      value = request.getMethod();
+      break;
+    case V_REQUEST_URI:
+      value = request.getUri();
+      if (request.getQueryString().empty() == false) {
+        value += "?" + request.getQueryString();
+      }
+      break;
+    case V_STATUS:
+      value = client.getStatusCode();
+      if (value.empty() == true) {
+        value = "499";
+      }
+      break;
+    case V_BYTES_SENT:
+      return toString(client.getBytesSent());
+    case V_REQUEST_TIME:
+      return toSeconds(client.getRequestTime());
+    case V_HOST:
+      value = request.getHost();
+      break;
+    case V_HTTP:
+      value = request.getHeader(token.text);
+      break;
+  }
+  if (value.empty() == true) {
+    return "-";
+  }
+  return escape(value);
+}
+
+/* quotes, backslashes and control bytes as \xHH, so a line stays one
+line and a quoted field stays quoted */
+std::string AccessLog::escape(const std::string& value) {
+  static const char HEX[] = "0123456789ABCDEF";
+  std::string escaped;
+
+  for (std::string::const_iterator it = value.begin(); it != value.end();
+       ++it) {
+    unsigned char c = *it;
+    if (c < 0x20 || c >= 0x7f || c == '"' || c == '\\') {
+      escaped += "\\x";
+      escaped += HEX[c >> 4];
+      escaped += HEX[c & 0xf];
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+/*======================//
+ structured
+========================*/
+
+/* phase times in microseconds, the script or upstream only when the
+request went there */
+std::string AccessLog::renderJson(const Client& client) {
+  const HttpRequest& request = client.getRequest();
+  const std::string& status = client.getStatusCode();
+  const Handler handler = getHandler(client);
+  std::string line;
+
+  line.reserve(BUFFER_SIZE);
+  line += "{\"time\":" + toString(Clock::now());
+  line += ",\"remote_addr\":\"" + escapeJson(client.getAddr().getIP());
+  line += "\",\"host\":\"" + escapeJson(request.getHost());
+  line += "\",\"method\":\"" + escapeJson(request.getMethod());
+  line += "\",\"uri\":\"" + escapeJson(request.getUri());
+  if (request.getQueryString().empty() == false) {
+    line += "?" + escapeJson(request.getQueryString());
+  }
+  line += "\",\"status\":" + (status.empty() ? "499" : status);
+  line += ",\"bytes_sent\":" + toString(client.getBytesSent());
+  line += ",\"request_time_us\":" + toString(client.getRequestTime());
+  line += ",\"phases_us\":{";
+  for (std::size_t i = 0; i < Metrics::PHASE_COUNT; ++i) {
+    line += (i == 0) ? "\"" : ",\"";
+    line += Metrics::PHASES[i];
+    line += "\":" + toString(client.getPhases()[i]);
+  }
+  line += "},\"handler\":\"";
+  line += HANDLERS[handler];
+  line += "\"";
+  if (handler == H_CGI) {
+    line += ",\"cgi_script\":\"" + escapeJson(getTarget(client)) + "\"";
+  } else if (handler == H_PROXY) {
+    line += ",\"upstream\":\"" + escapeJson(getTarget(client)) + "\"";
+  }
+  return line + "}\n";
+}
+
+/* little-endian: version, size, status (u16), handler, family (u8), time,
+bytes_sent (u64), five phases (u32), port (u16), 2 reserved, then the
+address, method, uri and target NUL padded to 16, 8, 120 and 64 bytes */
+std::string AccessLog::renderBinary(const Client& client) {
+  const HttpRequest& request = client.getRequest();
+  const sockaddr& address = client.getAddr().getAddress();
+  const std::string& status = client.getStatusCode();
+  std::string record;
+
+  record.reserve(BINARY_RECORD_SIZE);
+  putInteger(record, BINARY_VERSION, 2);
+  putInteger(record, BINARY_RECORD_SIZE, 2);
+  putInteger(record, status.empty() ? 499 : std::atoi(status.c_str()), 2);
+  putInteger(record, getHandler(client), 1);
+  putInteger(record, (address.sa_family == AF_INET) ? 4 : 0, 1);
+  putInteger(record, Clock::now(), 8);
+  putInteger(record, client.getBytesSent(), 8);
+  for (std::size_t i = 0; i < Metrics::PHASE_COUNT; ++i) {
+    uint64_t phase = client.getPhases()[i];
+    putInteger(record, std::min<uint64_t>(phase, 0xffffffff), 4);
+  }
+  if (address.sa_family == AF_INET) {
+    const sockaddr_in& inet = reinterpret_cast<const sockaddr_in&>(address);
+    putInteger(record, ntohs(inet.sin_port), 2);
+    putInteger(record, 0, 2);
+    putText(record,
+            std::string(reinterpret_cast<const char*>(&inet.sin_addr), 4),
+            16);
+  } else {
+    putInteger(record, 0, 4);
+    putText(record, "", 16);
+  }
+  putText(record, request.getMethod(), 8);
+  putText(record, request.getUri(), 120);
+  putText(record, getTarget(client), 64);
+  return record;
+}
+
+AccessLog::Handler AccessLog::getHandler(const Client& client) {
+  if (client.getLocation().isCgi() == true) {
+    return H_CGI;
+  }
+  if (client.getLocation().isProxy() == true) {
+    return H_PROXY;
+  }
+  return H_STATIC;
+}
+
+/* the script a CGI request ran or the server a proxied one went to */
+std::string AccessLog::getTarget(const Client& client) {
+  switch (getHandler(client)) {
+    case H_CGI:
+      return client.getFullUri();
+    case H_PROXY:
+      return client.getUpstream();
+    default:
+      return "";
+  }
+}
+
+/* quotes, backslashes, control and non ASCII bytes escaped. a byte above
+0x7f is written as the code point of the same value, so invalid UTF-8 still
+makes valid JSON */
+std::string AccessLog::escapeJson(const std::string& value) {
+  static const char HEX[] = "0123456789abcdef";
+  std::string escaped;
+
+  for (std::string::const_iterator it = value.begin(); it != value.end();
+       ++it) {
+    unsigned char c = *it;
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (c < 0x20 || 0x7f <= c) {
+      escaped += "\\u00";
+      escaped += HEX[c >> 4];
+      escaped += HEX[c & 0xf];
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+void AccessLog::putInteger(std::string& record, uint64_t value,
+                           std::size_t size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    record += static_cast<char>((value >> (i * 8)) & 0xff);
+  }
+}
+
+void AccessLog::putText(std::string& record, const std::string& text,
+                        std::size_t size) {
+  std::size_t length = std::min(text.size(), size);
+
+  record.append(text, 0, length);
+  record.append(size - length, '\0');
+}
+
+std::string AccessLog::toSeconds(uint64_t microseconds) {
+  std::ostringstream seconds;
+
+  seconds << std::fixed << std::setprecision(3) << microseconds / 1e6;
+  return seconds.str();
+}
@@ -2,37 +2,53 @@
 
 #include <cerrno>
 #include <cstring>
-#include <iostream>
 
 Client::Client(const int fd, const TcpServer* tcp_server,
                const SocketAddress& address, ServerManager* manager)
     : manager_(manager),
       fd_(fd),
-      session_(NULL),
       tcp_server_(tcp_server),
       address_(address),
       http_server_(NULL),
+      compressor_(NULL),
+      file_fd_(DEFAULT_FD),
+      file_offset_(0),
+      file_remaining_(0),
       status_(C200),
-      is_response_ready_(false) {}
+      bytes_sent_(0),
+      phase_mark_(0),
+      is_response_ready_(false) {
+  std::fill(phases_, phases_ + Metrics::PHASE_COUNT, 0);
+}
 
 Client::Client(const Client& origin)
     : manager_(origin.manager_),
       fd_(origin.fd_),
-      session_(origin.session_),
+      session_id_(origin.session_id_),
       tcp_server_(origin.tcp_server_),
       address_(origin.address_),
       http_server_(origin.http_server_),
       location_(origin.location_),
       request_(origin.request_),
       cgi_process_(origin.cgi_process_),
+      proxy_(origin.proxy_),
+      compressor_(NULL),
       fullUri_(origin.fullUri_),
       response_(origin.response_),
+      file_fd_(origin.file_fd_),
+      file_offset_(origin.file_offset_),
+      file_remaining_(origin.file_remaining_),
       status_(origin.status_),
-      is_response_ready_(origin.is_response_ready_) {}
+      status_code_(origin.status_code_),
+      bytes_sent_(origin.bytes_sent_),
+      phase_mark_(origin.phase_mark_),
+      is_response_ready_(origin.is_response_ready_) {
+  std::copy(origin.phases_, origin.phases_ + Metrics::PHASE_COUNT, phases_);
+}
 
 Client Client::operator=(const Client& origin) { return Client(origin); }
 
-Client::~Client() {}
+Client::~Client() { delete compressor_; }
 
 /*======================//
  Getter
@@ -40,8 +56,19 @@ Client::~Client() {}
 
 ServerManager* Client::getServerManager(void) { return manager_; }
 int Client::getFd() const { return fd_; }
-Session* Client::getSession(void) { return session_; }
-const Session* Client::getSession(void) const { return session_; }
+/* looked up on use, the store may have expired it since */
+Session* Client::getSession(void) {
+  if (http_server_ == NULL || session_id_.empty() == true) {
+    return NULL;
+  }
+  return http_server_->getSession(session_id_);
+}
+const Session* Client::getSession(void) const {
+  if (http_server_ == NULL || session_id_.empty() == true) {
+    return NULL;
+  }
+  return http_server_->getSession(session_id_);
+}
 const TcpServer* Client::getTcpServer(void) const { return tcp_server_; }
 HttpServer* Client::getHttpServer(void) const { return http_server_; }
 const SocketAddress Client::getAddr(void) const { return address_; }
@@ -50,72 +77,96 @@ const Location& Client::getLocation(void) const { return location_; }
 HttpRequest& Client::getRequest(void) { return request_; }
 const HttpRequest& Client::getRequest(void) const { return request_; }
 Process& Client::getProcess(void) { return cgi_process_; }
+const Process& Client::getProcess(void) const { return cgi_process_; }
+ProxyConnection& Client::getProxy(void) { return proxy_; }
+Compressor* Client::getCompressor(void) { return compressor_; }
 std::string& Client::getResponse(void) { return response_; }
 const std::string& Client::getResponse(void) const { return response_; }
 int& Client::getStatus(void) { return status_; }
 const int& Client::getStatus(void) const { return status_; }
 std::string& Client::getFullUri(void) { return fullUri_; }
 const std::string& Client::getFullUri(void) const { return fullUri_; }
+const std::string& Client::getStatusCode(void) const { return status_code_; }
+std::size_t Client::getBytesSent(void) const { return bytes_sent_; }
+
+/* the time charged to the phases of the request so far */
+uint64_t Client::getRequestTime(void) const {
+  uint64_t total = 0;
+  for (std::size_t i = 0; i < Metrics::PHASE_COUNT; ++i) {
+    total += phases_[i];
+  }
+  return total;
+}
+
+const uint64_t* Client::getPhases(void) const { return phases_; }
+
+/* "host:port" of the server the request was proxied to, if any */
+std::string Client::getUpstream(void) const {
+  if (proxy_.pool == NULL) {
+    return "";
+  }
+  return proxy_.pool->getHost() + ":" + proxy_.pool->getPort();
+}
 
 /*======================//
  Setter
 ========================*/
 
 void Client::setStatus(int status) { status_ = status; }
-void Client::setSession(Session* session) { session_ = session; }
+void Client::setStatusCode(const std::string& code) { status_code_ = code; }
+void Client::setSession(Session* session) { session_id_ = session->getID(); }
 void Client::setProcess(Process& cgi_process) { cgi_process_ = cgi_process; }
+void Client::setProxy(const ProxyConnection& proxy) { proxy_ = proxy; }
+void Client::setCompressor(Compressor* compressor) {
+  delete compressor_;
+  compressor_ = compressor;
+}
 
 void Client::setClientTimeout(std::time_t time) {
   timeout_ = time + KEEPALIVE_TIMEOUT;
   setTimer();
 }
 
-void Client::setSessionTimeout() {
-  if (session_) {
-    session_->setTimeout();
-  }
-  setTimer();
-}
-
 void Client::setAllTimeout(std::time_t time) {
   timeout_ = time + KEEPALIVE_TIMEOUT;
-  if (session_) {
-    session_->setTimeout();
+  if (session_id_.empty() == false) {
+    http_server_->touchSession(session_id_, time);
   }
   setTimer();
 }
 
 void Client::setTimer(std::time_t time) {
   time_t timeout = timeout_ - time;
-  if (session_) {
-    timeout = std::min(timeout_, session_->getTimeout()) - time;
-  }
   manager_->createEvent(fd_, EVFILT_TIMER, EV_DELETE, 0, 0, this);
   manager_->createEvent(fd_, EVFILT_TIMER, EV_ADD | EV_ONESHOT, NOTE_SECONDS,
                         timeout, this);
 }
 
-void Client::handleTimeout() {
-  if (session_ && session_->getTimeout() < std::time(NULL)) {
-    http_server_->destroySession(session_->getID());
-    delete session_;
-    session_ = NULL;
-    std::cout << "!!!!!!!!!!!!!!!!!!!!!!!!!";
-  }
-  throw ConnectionClosedException(fd_);
-}
+/* expired sessions are swept by the server, not by their connection */
+void Client::handleTimeout() { throw ConnectionClosedException(fd_); }
 
 /*======================//
  process
 ========================*/
 
 /* recognize a type of event */
-void Client::processEvent(const int event_type) {
-  if (isCgiStarted() == true) {
-    passToCgi(event_type);
+void Client::processEvent(const struct kevent& event) {
+  bool is_client_write = (event.filter == EVFILT_WRITE &&
+                          event.ident == static_cast<uintptr_t>(fd_));
+
+  if (isCgiStarted() == true && is_client_write == false) {
+    passToCgi(event);
     return;
   }
-  switch (event_type) {
+  if (isProxyStarted() == true && is_client_write == false) {
+    passToProxy(event);
+    return;
+  }
+  /* left over from an upstream connection that is already released */
+  if (event.ident != static_cast<uintptr_t>(fd_)) {
+    return;
+  }
+  switch (event.filter) {
     case EVFILT_READ:
       processRequest();
       break;
@@ -137,12 +188,24 @@ void Client::processRequest(void) {
   try {
     setClientTimeout();
     std::string data = readData();
+    bool was_started = request_.isStarted();
+    bool was_completed = request_.isCompleted();
     request_.tailRequest(data);
+    if (was_started == false) {
+      Metrics::beginRead();
+      phase_mark_ = Clock::getMicroseconds();
+    }
     request_.parse();
 
+    if (request_.isCompleted() == true && was_completed == false) {
+      Metrics::endRead();
+      Metrics::beginRequest();
+      markPhase(Metrics::PARSE);
+    }
     if (request_.isCompleted() == true) {
       lookUpHttpServer();
       lookUpLocation();
+      markPhase(Metrics::LOOKUP);
       setFullUri();
       setSession();
       validAuth();
@@ -170,6 +233,7 @@ std::string Client::readData(void) {
   if (read_bytes == 0) {
     throw std::runtime_error("no data in buffer");
   }
+  Metrics::countBytesIn(read_bytes);
   return std::string(buffer, read_bytes);
 }
 
@@ -199,18 +263,21 @@ void Client::setFullUri(void) {
 }
 
 void Client::setSession(void) {
+  session_id_.clear();
   if (request_.hasCookie() == false) {
     return;
   }
   const std::string session_id = request_.getCookie(SESSION_ID_FIELD);
-  session_ = http_server_->getSession(session_id);
+  if (http_server_->touchSession(session_id, Clock::now()) != NULL) {
+    session_id_ = session_id;
+  }
 }
 
 void Client::validAuth(void) {
   if (location_.getAuth() == false) {
     return;
   }
-  if (session_ == NULL) {
+  if (getSession() == NULL) {
     throw ResponseException(C403);
   }
 }
@@ -225,12 +292,26 @@ void Client::passErrorToHandler(int status) {
 void Client::passRequestToHandler(void) {
   struct Response response_from_upsteam;
   try {
-    if (location_.isCgi() == true && isErrorCode() == false) {
+    int cache = CACHE_PASS;
+    if (isCacheable() == true) {
+      cache = ResponseCache::lookup(this, response_from_upsteam);
+    }
+    if (cache == CACHE_WAIT) {
+      return;
+    } else if (cache == CACHE_HIT) {
+      /* response_from_upsteam is the cached one */
+    } else if (location_.isProxy() == true && isErrorCode() == false) {
+      ProxyHandler::execute(this);
+      return;
+    } else if (location_.isCgi() == true && isErrorCode() == false) {
       if (isCgiStarted() == false) {
         CgiHandler::execute(this);
         return;
       }
       response_from_upsteam = CgiHandler::getResponse(this);
+    } else if (location_.getStubStatus().empty() == false &&
+               isErrorCode() == false) {
+      response_from_upsteam = StatusHandler::handle(this);
     } else if (SessionHandler::recognizeRequest(request_) == true) {
       response_from_upsteam = SessionHandler::handle(this);
     } else if (location_.getAutoindex() == true && isErrorCode() == false) {
@@ -242,25 +323,65 @@ void Client::passRequestToHandler(void) {
     status_ = e.status;
     response_from_upsteam = StaticContentHandler::handle(this);
   }
+  markPhase(Metrics::HANDLE);
+  Compressor::encode(this, response_from_upsteam);
   response_ = ResponseGenerator::generateResponse(*this, response_from_upsteam);
+  setFileBody(response_from_upsteam);
+  markPhase(Metrics::GENERATE);
   setToSend(true);
 }
 
-void Client::passToCgi(const int event_type) {
+void Client::passToCgi(const struct kevent& event) {
   try {
-    CgiHandler::handle(this, event_type);
+    CgiHandler::handle(this, event);
     if (isCgiDone() == true) {
       passRequestToHandler();
     }
   } catch (const ResponseException& e) {
+    bool is_header_sent = cgi_process_.stream.is_header_sent;
     CgiHandler::setPhase(this, P_RESET);
+    /* part of the response is already out, the status can not change */
+    if (is_header_sent == true) {
+      throw ConnectionClosedException(fd_);
+    }
     passErrorToHandler(e.status);
   }
 }
 
+void Client::passToProxy(const struct kevent& event) {
+  try {
+    ProxyHandler::handle(this, event);
+  } catch (const ResponseException& e) {
+    bool is_header_sent = proxy_.stream.is_header_sent;
+    ProxyHandler::setPhase(this, P_RESET);
+    if (is_header_sent == true) {
+      throw ConnectionClosedException(fd_);
+    }
+    passErrorToHandler(e.status);
+  }
+}
+
+/* called by the CGI limiter once the queued request may run,
+or with an error status when it waited too long */
+void Client::resumeCgi(int status) {
+  cgi_process_.phase = P_UNSTARTED;
+  cgi_process_.limiter = NULL;
+  if (status != C200) {
+    passErrorToHandler(status);
+    return;
+  }
+  passRequestToHandler();
+}
+
+/* called by the cache once the response this request waited for is
+stored, or its fill failed */
+void Client::resumeFromCache(void) { passRequestToHandler(); }
+
 /* send the response to client */
 void Client::writeData(void) {
-  setAllTimeout();
+  if (isCgiStarted() == false && isProxyStarted() == false) {
+    setAllTimeout();
+  }
 
   std::size_t write_bytes;
   if (is_response_ready_ == false) {
@@ -271,17 +392,76 @@ void Client::writeData(void) {
     throw ConnectionClosedException(fd_);
   }
 
+  countBytesOut(write_bytes);
   response_.erase(0, write_bytes);
+  if (response_.empty() == true && file_fd_ != DEFAULT_FD) {
+    sendFileBody();
+    return;
+  }
+  if (isCgiStarted() == true) {
+    CgiHandler::drain(this);
+    return;
+  }
+  if (isProxyStarted() == true) {
+    ProxyHandler::drain(this);
+    return;
+  }
   if (response_.empty() == true) {
     setToSend(false);
     clear();
   }
 }
 
+/* the body of a response kept in a file follows its header */
+void Client::setFileBody(const Response& response) {
+  if (response.file_fd == DEFAULT_FD) {
+    return;
+  }
+  if (request_.getMethod() == METHODS[HEAD] || response.file_size == 0) {
+    close(response.file_fd);
+    return;
+  }
+  file_fd_ = response.file_fd;
+  file_offset_ = response.file_offset;
+  file_remaining_ = response.file_size;
+}
+
+void Client::sendFileBody(void) {
+  ssize_t sent = sendFile(fd_, file_fd_, file_offset_, file_remaining_);
+  if (sent == ERROR<ssize_t>()) {
+    if (errno == EAGAIN) {
+      return;
+    }
+    throw ConnectionClosedException(fd_);
+  }
+  countBytesOut(sent);
+  file_offset_ += sent;
+  file_remaining_ -= sent;
+  if (file_remaining_ == 0) {
+    setToSend(false);
+    clear();
+  }
+}
+
+void Client::countBytesOut(std::size_t bytes) {
+  Metrics::countBytesOut(bytes);
+  bytes_sent_ += bytes;
+}
+
 /*======================//
  utils
 ========================*/
 
+/* charge the time since the last mark to phase */
+void Client::markPhase(int phase) {
+  if (phase_mark_ == 0) {
+    return;
+  }
+  uint64_t now = Clock::getMicroseconds();
+  phases_[phase] += now - phase_mark_;
+  phase_mark_ = now;
+}
+
 /* turn on/off event, is_response_ready */
 void Client::setToSend(bool set) {
   is_response_ready_ = set;
@@ -305,10 +485,64 @@ bool Client::isCgiStarted(void) { return (cgi_process_.phase != P_UNSTARTED); }
 
 bool Client::isCgiDone(void) { return (cgi_process_.phase == P_DONE); }
 
+bool Client::isProxyStarted(void) { return (proxy_.phase != P_UNSTARTED); }
+
+/* GET and HEAD of a CGI or proxied location with cache_ttl, before
+anything started. auth locations answer per user */
+bool Client::isCacheable(void) {
+  const std::string& method = request_.getMethod();
+
+  return (location_.getCacheTtl() != 0 && location_.getAuth() == false &&
+          (location_.isCgi() == true || location_.isProxy() == true) &&
+          (method == METHODS[GET] || method == METHODS[HEAD]) &&
+          isErrorCode() == false && isCgiStarted() == false);
+}
+
 void Client::clear() {
+  if (request_.isCompleted() == true && response_.empty() == true &&
+      file_remaining_ == 0) {
+    markPhase(Metrics::DRAIN);
+    Metrics::recordLatency(location_.getUri(), phases_);
+  }
+  if (request_.isCompleted() == true || status_code_.empty() == false) {
+    logRequest();
+  }
+  std::fill(phases_, phases_ + Metrics::PHASE_COUNT, 0);
+  phase_mark_ = 0;
+  if (request_.isCompleted() == true) {
+    Metrics::endRequest();
+  } else if (request_.isStarted() == true) {
+    Metrics::endRead();
+  }
+  ResponseCache::cancel(this);
+  if (file_fd_ != DEFAULT_FD) {
+    close(file_fd_);
+    file_fd_ = DEFAULT_FD;
+    file_remaining_ = 0;
+  }
+  setCompressor(NULL);
   request_.clear();
   fullUri_.clear();
   status_ = C200;
+  status_code_.clear();
+  bytes_sent_ = 0;
   is_response_ready_ = false;
   cgi_process_.phase = P_UNSTARTED;
+  cgi_process_.pid = 0;
+  proxy_.phase = P_UNSTARTED;
+  proxy_.pool = NULL;
+}
+
+/* a request rejected before its server was looked up is logged by the
+server its Host names */
+void Client::logRequest(void) {
+  HttpServer* http_server = http_server_;
+
+  if (http_server == NULL) {
+    http_server = tcp_server_->getVirtualServer(request_.getHost());
+  }
+  if (http_server != NULL) {
+    http_server->logAccess(*this);
+    http_server->logSlow(*this);
+  }
 }
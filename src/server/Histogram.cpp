@@ -0,0 +1,67 @@
+#include "Histogram.hpp"
+
+#include <cmath>
+
+Histogram::Histogram() : count_(0), sum_(0) {
+  for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+    buckets_[i] = 0;
+  }
+}
+
+void Histogram::record(uint64_t value) {
+  buckets_[indexOf(value)] += 1;
+  count_ += 1;
+  sum_ += value;
+}
+
+uint64_t Histogram::count(void) const { return count_; }
+
+uint64_t Histogram::sum(void) const { return sum_; }
+
+/* the upper bound of the bucket holding the q-th value, 0 when empty */
+uint64_t Histogram::quantile(double q) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(std::ceil(q * count_));
+  if (rank == 0) {
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+    seen += buckets_[i];
+    if (rank <= seen) {
+      return upperBound(i);
+    }
+  }
+  return upperBound(BUCKET_COUNT - 1);
+}
+
+/*======================//
+ buckets
+========================*/
+
+/* the highest bit picks the group, the SUB_BITS below it the bucket */
+std::size_t Histogram::indexOf(uint64_t value) {
+  if (value < SUB_COUNT) {
+    return value;
+  }
+  std::size_t bit = SUB_BITS;
+  while (bit < MAX_BIT && (value >> (bit + 1)) != 0) {
+    bit += 1;
+  }
+  if ((value >> (bit + 1)) != 0) {
+    return BUCKET_COUNT - 1;
+  }
+  std::size_t sub = (value >> (bit - SUB_BITS)) - SUB_COUNT;
+  return SUB_COUNT + (bit - SUB_BITS) * SUB_COUNT + sub;
+}
+
+uint64_t Histogram::upperBound(std::size_t index) {
+  if (index < SUB_COUNT) {
+    return index;
+  }
+  std::size_t shift = (index - SUB_COUNT) / SUB_COUNT;
+  uint64_t sub = (index - SUB_COUNT) % SUB_COUNT;
+  return ((SUB_COUNT + sub + 1) << shift) - 1;
+}
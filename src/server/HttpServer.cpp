@@ -1,20 +1,55 @@
 #include "HttpServer.hpp"
 
+#include "CgiLimiter.hpp"
+#include "CgiWorkerPool.hpp"
+#include "Clock.hpp"
+#include "DiskCache.hpp"
+#include "UpstreamGroup.hpp"
+
 HttpServer::HttpServer(const int id, const ServerBlock& server_block)
     : server_id_(id),
       locations_(server_block.locations),
-      error_pages_(server_block.error_pages) {}
-
-HttpServer::HttpServer(const HttpServer& origin)
-    : server_id_(origin.server_id_),
-      locations_(origin.locations_),
-      error_pages_(origin.error_pages_),
-      sessions_(origin.sessions_) {}
+      error_pages_(server_block.error_pages),
+      slow_log_(server_block.slow_log_path, server_block.slow_log_threshold),
+      sessions_(new SessionStore(server_block.session_path,
+                                 server_block.snapshot_path)) {
+  for (LocationType::const_iterator it = locations_.begin();
+       it != locations_.end(); ++it) {
+    if (it->getCgiParam("CGI_PATH").empty() == false) {
+      cgi_envs_.insert(
+          std::make_pair(it->getUri(), CgiEnvironment(server_id_, *it)));
+      cgi_limiters_[it->getUri()] = new CgiLimiter(*it);
+    }
+    if (it->getCgiParam("CGI_POOL_WORKER").empty() == false) {
+      cgi_pools_[it->getUri()] = new CgiWorkerPool(*it);
+    }
+    if (it->getCachePath().empty() == false) {
+      DiskCache::open(it->getCachePath());
+    }
+    if (it->isProxy() == true) {
+      upstream_groups_[it->getUri()] =
+          UpstreamGroup::find(it->getProxyHost(), it->getProxyPort());
+    }
+  }
+  for (std::map<std::string, std::string>::const_iterator it =
+           server_block.access_logs.begin();
+       it != server_block.access_logs.end(); ++it) {
+    access_logs_.push_back(AccessLog(it->first, it->second));
+  }
+}
 
-HttpServer HttpServer::operator=(const HttpServer& origin) {
-  return HttpServer(origin);
+/* upstream groups and disk caches are shared registries, not owned here */
+HttpServer::~HttpServer() {
+  for (CgiPoolType::iterator it = cgi_pools_.begin(); it != cgi_pools_.end();
+       ++it) {
+    delete it->second;
+  }
+  for (CgiLimiterType::iterator it = cgi_limiters_.begin();
+       it != cgi_limiters_.end(); ++it) {
+    delete it->second;
+  }
+  delete sessions_;
 }
-HttpServer::~HttpServer() {}
 
 const Location& HttpServer::findLocation(const std::string& request_uri) const {
   std::size_t index = find(request_uri);
@@ -61,23 +96,89 @@ const std::string& HttpServer::getErrorPage(const std::string& code) const {
 }
 
 Session* HttpServer::getSession(const std::string& id) const {
-  SessionType::const_iterator session = sessions_.find(id);
+  return sessions_->find(id, Clock::now());
+}
+
+const SessionStore& HttpServer::getSessions(void) const { return *sessions_; }
+
+/* persistent CGI workers of the location, NULL if it forks per request */
+CgiWorkerPool* HttpServer::getCgiPool(const std::string& location_uri) const {
+  CgiPoolType::const_iterator pool = cgi_pools_.find(location_uri);
 
-  if (session == sessions_.end()) {
+  if (pool == cgi_pools_.end()) {
     return NULL;
   }
-  return session->second;
+  return pool->second;
+}
+
+CgiLimiter* HttpServer::getCgiLimiter(const std::string& location_uri) const {
+  CgiLimiterType::const_iterator limiter = cgi_limiters_.find(location_uri);
+
+  if (limiter == cgi_limiters_.end()) {
+    return NULL;
+  }
+  return limiter->second;
+}
+
+const CgiEnvironment* HttpServer::getCgiEnvironment(
+    const std::string& location_uri) const {
+  CgiEnvType::const_iterator env = cgi_envs_.find(location_uri);
+
+  if (env == cgi_envs_.end()) {
+    return NULL;
+  }
+  return &env->second;
+}
+
+UpstreamGroup* HttpServer::getUpstreamGroup(
+    const std::string& location_uri) const {
+  UpstreamGroupType::const_iterator group = upstream_groups_.find(location_uri);
+
+  if (group == upstream_groups_.end()) {
+    return NULL;
+  }
+  return group->second;
 }
 
 bool HttpServer::isExistSessionId(std::string& id) {
-  if (sessions_.find(id) == sessions_.end()) {
-    return false;
+  return sessions_->find(id, Clock::now()) != NULL;
+}
+
+void HttpServer::addSession(Session* session, std::time_t now) {
+  sessions_->insert(session, now);
+}
+
+Session* HttpServer::touchSession(const std::string& id, std::time_t now) {
+  return sessions_->touch(id, now);
+}
+
+void HttpServer::destroySession(const std::string& id) {
+  sessions_->erase(id);
+}
+
+void HttpServer::expireSessions(std::time_t now) { sessions_->sweep(now); }
+
+void HttpServer::maintainCgiPools(std::time_t now) {
+  for (CgiPoolType::iterator it = cgi_pools_.begin(); it != cgi_pools_.end();
+       ++it) {
+    it->second->maintain(now);
   }
-  return true;
 }
 
-void HttpServer::addSession(std::string& id, Session* session) {
-  sessions_[id] = session;
+void HttpServer::expireCgiQueues(std::time_t now) {
+  for (CgiLimiterType::iterator it = cgi_limiters_.begin();
+       it != cgi_limiters_.end(); ++it) {
+    it->second->expire(now);
+  }
 }
 
-void HttpServer::destroySession(const std::string& id) { sessions_.erase(id); }
\ No newline at end of file
+void HttpServer::logAccess(const Client& client) const {
+  for (std::vector<AccessLog>::const_iterator it = access_logs_.begin();
+       it != access_logs_.end(); ++it) {
+    it->write(client);
+  }
+}
+
+void HttpServer::logSlow(const Client& client) { slow_log_.write(client); }
+
+void HttpServer::flushSlowLog(std::time_t now) { slow_log_.flush(now); }
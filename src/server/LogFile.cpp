@@ -0,0 +1,137 @@
+#include "LogFile.hpp"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include "Error.hpp"
+#include "Spawner.hpp"
+#include "utility.hpp"
+
+std::map<std::string, LogFile*> LogFile::files_;
+
+LogFile::LogFile(const std::string& path)
+    : path_(path),
+      is_socket_(path.compare(0, ACCESS_LOG_SOCKET_PREFIX.size(),
+                              ACCESS_LOG_SOCKET_PREFIX) == 0) {
+  fd_ = (is_socket_ == true) ? openSocket() : openFile();
+  if (fd_ == ERROR<int>()) {
+    Error::log(Error::INFO[EOPEN], path_, EXIT_FAILURE);
+  }
+  buffer_.reserve(capacity());
+}
+
+LogFile::~LogFile() {
+  flush();
+  close(fd_);
+}
+
+void LogFile::append(const std::string& line) {
+  if (buffer_.empty() == false &&
+      buffer_.size() + line.size() > capacity()) {
+    flush();
+  }
+  buffer_ += line;
+}
+
+/* a failed write drops the buffer rather than letting it grow */
+void LogFile::flush(void) {
+  if (is_socket_ == true) {
+    if (buffer_.empty() == false) {
+      sendto(fd_, buffer_.c_str(), buffer_.size(), 0,
+             reinterpret_cast<struct sockaddr*>(&address_), sizeof(address_));
+    }
+    buffer_.clear();
+    return;
+  }
+  std::size_t written = 0;
+  while (written < buffer_.size()) {
+    ssize_t write_bytes =
+        write(fd_, buffer_.c_str() + written, buffer_.size() - written);
+    if (write_bytes == ERROR<ssize_t>()) {
+      break;
+    }
+    written += write_bytes;
+  }
+  buffer_.clear();
+}
+
+/* the old file is kept when the path can not be opened again, a
+socket is addressed on every send and has nothing to reopen */
+void LogFile::reopen(void) {
+  flush();
+  if (is_socket_ == true) {
+    return;
+  }
+  int fd = openFile();
+  if (fd == ERROR<int>()) {
+    Error::log(Error::INFO[EOPEN], path_);
+    return;
+  }
+  close(fd_);
+  fd_ = fd;
+}
+
+/*======================//
+ files
+========================*/
+
+LogFile* LogFile::open(const std::string& path) {
+  std::map<std::string, LogFile*>::iterator file = files_.find(path);
+
+  if (file != files_.end()) {
+    return file->second;
+  }
+  return files_[path] = new LogFile(path);
+}
+
+void LogFile::flushAll(void) {
+  for (std::map<std::string, LogFile*>::iterator it = files_.begin();
+       it != files_.end(); ++it) {
+    it->second->flush();
+  }
+}
+
+void LogFile::reopenAll(void) {
+  for (std::map<std::string, LogFile*>::iterator it = files_.begin();
+       it != files_.end(); ++it) {
+    it->second->reopen();
+  }
+}
+
+int LogFile::openFile(void) const {
+  return ::open(path_.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC,
+                0644);
+}
+
+/* the collector may start later, so only the path is checked here */
+int LogFile::openSocket(void) {
+  const std::string socket_path = path_.substr(ACCESS_LOG_SOCKET_PREFIX.size());
+
+  if (socket_path.empty() == true ||
+      socket_path.size() >= sizeof(address_.sun_path)) {
+    return ERROR<int>();
+  }
+  std::memset(&address_, 0, sizeof(address_));
+  address_.sun_family = AF_UNIX;
+  std::memcpy(address_.sun_path, socket_path.c_str(), socket_path.size());
+
+  int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (fd == ERROR<int>()) {
+    return ERROR<int>();
+  }
+  if (fcntl(fd, F_SETFL, O_NONBLOCK) == ERROR<int>() ||
+      Spawner::setCloseOnExec(fd) == ERROR<int>()) {
+    close(fd);
+    return ERROR<int>();
+  }
+  return fd;
+}
+
+std::size_t LogFile::capacity(void) const {
+  return (is_socket_ == true) ? ACCESS_LOG_DATAGRAM_SIZE
+                              : ACCESS_LOG_BUFFER_SIZE;
+}
@@ -0,0 +1,85 @@
+#include "Metrics.hpp"
+
+const char* const Metrics::PHASES[] = {"parse", "lookup", "handle",
+                                       "generate", "drain"};
+
+std::size_t Metrics::loops_ = 0;
+std::size_t Metrics::events_ = 0;
+std::size_t Metrics::accepted_ = 0;
+std::size_t Metrics::closed_ = 0;
+std::size_t Metrics::requests_ = 0;
+std::size_t Metrics::reading_ = 0;
+std::size_t Metrics::writing_ = 0;
+std::size_t Metrics::bytes_in_ = 0;
+std::size_t Metrics::bytes_out_ = 0;
+Metrics::StatusType Metrics::statuses_;
+Metrics::LatencyType Metrics::latencies_;
+
+/*======================//
+ count
+========================*/
+
+void Metrics::countLoop(std::size_t events) {
+  loops_ += 1;
+  events_ += events;
+}
+
+void Metrics::countAccept(void) { accepted_ += 1; }
+
+void Metrics::countClose(void) { closed_ += 1; }
+
+void Metrics::beginRead(void) { reading_ += 1; }
+
+void Metrics::endRead(void) { reading_ -= 1; }
+
+void Metrics::beginRequest(void) {
+  requests_ += 1;
+  writing_ += 1;
+}
+
+void Metrics::endRequest(void) { writing_ -= 1; }
+
+void Metrics::countStatus(const std::string& code) { statuses_[code] += 1; }
+
+void Metrics::countBytesIn(std::size_t size) { bytes_in_ += size; }
+
+void Metrics::countBytesOut(std::size_t size) { bytes_out_ += size; }
+
+/* the microseconds of every phase of one request */
+void Metrics::recordLatency(const std::string& location,
+                            const uint64_t* phases) {
+  std::vector<Histogram>& histograms = latencies_[location];
+
+  if (histograms.empty() == true) {
+    histograms.resize(PHASE_COUNT);
+  }
+  for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+    histograms[i].record(phases[i]);
+  }
+}
+
+/*======================//
+ read
+========================*/
+
+std::size_t Metrics::getLoops(void) { return loops_; }
+
+std::size_t Metrics::getEvents(void) { return events_; }
+
+std::size_t Metrics::getAccepted(void) { return accepted_; }
+
+std::size_t Metrics::getActive(void) { return accepted_ - closed_; }
+
+std::size_t Metrics::getRequests(void) { return requests_; }
+
+std::size_t Metrics::getReading(void) { return reading_; }
+
+std::size_t Metrics::getWriting(void) { return writing_; }
+
+std::size_t Metrics::getBytesIn(void) { return bytes_in_; }
+
+std::size_t Metrics::getBytesOut(void) { return bytes_out_; }
+
+const Metrics::StatusType& Metrics::getStatuses(void) { return statuses_; }
+
+const Metrics::LatencyType& Metrics::getLatencies(void) { return latencies_; }
@@ -21,6 +21,12 @@ void ServerManager::registerServer(const Config &config) {
   TcpServer *tcp_server;
   HttpServer *http_server;
 
+  MimeTypes::define(config.getTypes());
+  const std::vector<UpstreamBlock> &upstreams = config.getUpstreamBlocks();
+  for (std::vector<UpstreamBlock>::const_iterator it = upstreams.begin();
+       it != upstreams.end(); ++it) {
+    UpstreamGroup::define(*it);
+  }
   for (std::vector<ServerBlock>::iterator it = servers.begin();
        it != servers.end(); ++it) {
     listens = it->listens;
@@ -64,7 +70,16 @@ HttpServer *ServerManager::createHttpServer(const ServerBlock &server_block) {
  set server
 ========================*/
 
-void ServerManager::setServer(void) { bindServers(); }
+void ServerManager::setServer(void) {
+  bindServers();
+  supervise();
+  createEvent(kq_, EVFILT_TIMER, EV_ADD | EV_ENABLE, NOTE_SECONDS,
+              SUPERVISE_INTERVAL, NULL);
+  createEvent(SIGCHLD, EVFILT_SIGNAL, EV_ADD | EV_ENABLE, 0, 0, NULL);
+  createEvent(SIGUSR1, EVFILT_SIGNAL, EV_ADD | EV_ENABLE, 0, 0, NULL);
+  createEvent(SIGTERM, EVFILT_SIGNAL, EV_ADD | EV_ENABLE, 0, 0, NULL);
+  createEvent(SIGINT, EVFILT_SIGNAL, EV_ADD | EV_ENABLE, 0, 0, NULL);
+}
 
 /* bind each server to listen socket,
 append the listen socket on chanege list */
@@ -94,7 +109,7 @@ void ServerManager::bindServers(void) {
 /* create and set a listen socket for each server */
 int ServerManager::createListenSocket(void) const {
   int fd = socket(AF_INET, SOCK_STREAM, 0);
-  if (fd == -1) {
+  if (fd == -1 || Spawner::setCloseOnExec(fd) == -1) {
     throw std::runtime_error(strerror(errno));
   }
 
@@ -138,10 +153,27 @@ void ServerManager::runServer(void) {
       throw std::runtime_error(strerror(errno));
     }
     change_event_list.clear();
+    Clock::update();
+    Metrics::countLoop(events);
     processEventOnQueue(events);
   }
 }
 
+/* drop the clients and the virtual servers so their sessions, workers and
+logs are written out, then leave */
+void ServerManager::stopServer(void) {
+  while (clients_.empty() == false) {
+    unconnectClient(clients_.begin()->first);
+  }
+  for (HttpServerType::iterator it = http_servers_.begin();
+       it != http_servers_.end(); ++it) {
+    delete *it;
+  }
+  http_servers_.clear();
+  LogFile::flushAll();
+  std::exit(EXIT_SUCCESS);
+}
+
 /* recognize where is event occurred */
 void ServerManager::processEventOnQueue(const int events) {
   struct kevent event;
@@ -149,13 +181,45 @@ void ServerManager::processEventOnQueue(const int events) {
 
   for (int i = 0; i < events; ++i) {
     event = event_list[i];
+    if (event.flags & EV_ERROR) {
+      processEventError(event);
+      continue;
+    }
+    if (event.filter == EVFILT_TIMER &&
+        event.ident == static_cast<uintptr_t>(kq_)) {
+      supervise();
+      continue;
+    }
+    /* log rotation moved the files, continue in new ones */
+    if (event.filter == EVFILT_SIGNAL && event.ident == SIGUSR1) {
+      LogFile::reopenAll();
+      continue;
+    }
+    /* asked to stop, leave with the state written out */
+    if (event.filter == EVFILT_SIGNAL &&
+        (event.ident == SIGTERM || event.ident == SIGINT)) {
+      stopServer();
+    }
+    if (event.filter == EVFILT_PROC || event.filter == EVFILT_SIGNAL) {
+      ProcessTable::reap();
+      notifyExit(event);
+      continue;
+    }
+    if (probe_sockets_.find(event.ident) != probe_sockets_.end()) {
+      probe_sockets_[event.ident]->handleProbe(this, event);
+      continue;
+    }
+    /* left over from a health check closed earlier in this batch */
+    if (event.udata == NULL) {
+      continue;
+    }
     if (listen_sockets_.find(event.ident) != listen_sockets_.end()) {
       acceptNewClient(event.ident, static_cast<TcpServer *>(event.udata));
       continue;
     }
     client = static_cast<Client *>(event.udata);
     try {
-      client->processEvent(event.filter);
+      client->processEvent(event);
     } catch (const ConnectionClosedException &e) {
       unconnectClient(e.client_fd);
     } catch (const std::runtime_error &e) {
@@ -164,6 +228,71 @@ void ServerManager::processEventOnQueue(const int events) {
   }
 }
 
+/* a change in the list was refused. one on a descriptor closed or a filter
+deleted earlier in the batch (a dead pool worker, a released upstream) belongs
+to a request that is already over. any other leaves its owner waiting */
+void ServerManager::processEventError(const struct kevent &event) {
+  int error = static_cast<int>(event.data);
+
+  if (error == ENOENT || error == EBADF) {
+    return;
+  }
+  Error::log(Error::INFO[ESYSTEM], std::string("kevent: ") + strerror(error));
+  /* the child exited before it was watched */
+  if (event.filter == EVFILT_PROC) {
+    ProcessTable::reap();
+    notifyExit(event);
+    return;
+  }
+  if (event.udata == NULL ||
+      listen_sockets_.find(event.ident) != listen_sockets_.end() ||
+      probe_sockets_.find(event.ident) != probe_sockets_.end()) {
+    return;
+  }
+  Client *client = static_cast<Client *>(event.udata);
+  ClientType::iterator it = clients_.find(client->getFd());
+  if (it != clients_.end() && it->second == client) {
+    unconnectClient(client->getFd());
+  }
+}
+
+/* a CGI request may wait for the exit status of its script */
+void ServerManager::notifyExit(const struct kevent &event) {
+  if (event.filter != EVFILT_PROC || event.udata == NULL) {
+    return;
+  }
+  Client *client = static_cast<Client *>(event.udata);
+  ClientType::iterator it = clients_.find(client->getFd());
+  if (it == clients_.end() || it->second != client) {
+    return;
+  }
+  try {
+    client->processEvent(event);
+  } catch (const ConnectionClosedException &e) {
+    unconnectClient(e.client_fd);
+  } catch (const std::runtime_error &e) {
+    return;
+  }
+}
+
+/* periodic housekeeping that does not belong to a single client */
+void ServerManager::supervise(void) {
+  std::time_t now = Clock::now();
+
+  ProcessTable::reap();
+  for (HttpServerType::iterator it = http_servers_.begin();
+       it != http_servers_.end(); ++it) {
+    (*it)->maintainCgiPools(now);
+    (*it)->expireCgiQueues(now);
+    (*it)->expireSessions(now);
+    (*it)->flushSlowLog(now);
+  }
+  UpstreamGroup::maintainAll(this, now);
+  ResponseCache::expire(now);
+  DiskCache::sweepAll(now);
+  LogFile::flushAll();
+}
+
 /* accept client, create Client instance with fd, tcp server */
 void ServerManager::acceptNewClient(const int server_socker,
                                     const TcpServer *tcp_server) {
@@ -175,7 +304,8 @@ void ServerManager::acceptNewClient(const int server_socker,
     throw std::runtime_error(strerror(errno));
   }
 
-  if (fcntl(client_fd, F_SETFL, O_NONBLOCK) == -1) {
+  if (fcntl(client_fd, F_SETFL, O_NONBLOCK) == -1 ||
+      Spawner::setCloseOnExec(client_fd) == -1) {
     close(client_fd);
     throw std::runtime_error(strerror(errno));
   }
@@ -192,9 +322,21 @@ void ServerManager::createClient(const int client_fd,
   createEvent(client_fd, EVFILT_TIMER, EV_ADD | EV_ONESHOT, NOTE_SECONDS,
               KEEPALIVE_TIMEOUT, new_client);
   clients_[client_fd] = new_client;
+  Metrics::countAccept();
 }
 
 void ServerManager::unconnectClient(const int client_fd) {
+  ClientType::iterator client = clients_.find(client_fd);
+  if (client != clients_.end() && client->second->isCgiStarted() == true) {
+    CgiHandler::setPhase(client->second, P_RESET);
+  }
+  if (client != clients_.end() && client->second->isProxyStarted() == true) {
+    ProxyHandler::setPhase(client->second, P_RESET);
+  }
+  if (client != clients_.end()) {
+    client->second->clear();
+    Metrics::countClose();
+  }
   close(client_fd);
   clients_.erase(client_fd);
 }
@@ -212,6 +354,13 @@ void ServerManager::createEvent(uintptr_t ident, int16_t filter, uint16_t flags,
   change_event_list.push_back(event);
 }
 
+/* health check sockets are dispatched to their upstream group */
+void ServerManager::watchProbe(int fd, UpstreamGroup *group) {
+  probe_sockets_[fd] = group;
+}
+
+void ServerManager::unwatchProbe(int fd) { probe_sockets_.erase(fd); }
+
 void ServerManager::createListenEvent(int fd, TcpServer *server) {
   createEvent(fd, EVFILT_READ, EV_ADD | EV_ENABLE, 0, 0, server);
 }
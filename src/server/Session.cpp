@@ -1,5 +1,7 @@
 #include "Session.hpp"
 
+#include "utility.hpp"
+
 Session::Session(const std::string& id) : id_(id) {}
 
 Session::Session(const std::string& id, ValueType values)
@@ -36,3 +38,36 @@ const std::string& Session::getValue(std::string key) const {
   }
   return value->second;
 }
+
+const Session::ValueType& Session::getValues() const { return values_; }
+
+/*======================//
+ Serialize
+========================*/
+
+/* values go in the query string form they were posted in */
+std::string Session::encode(void) const {
+  std::string data;
+
+  for (ValueType::const_iterator it = values_.begin(); it != values_.end();
+       ++it) {
+    if (it != values_.begin()) {
+      data += "&";
+    }
+    data += it->first + "=" + it->second;
+  }
+  return data;
+}
+
+Session::ValueType Session::decode(const std::string& data) {
+  std::vector<std::string> pairs = split(data, "&");
+  ValueType values;
+
+  for (std::size_t i = 0; i < pairs.size(); ++i) {
+    std::size_t equal = pairs[i].find("=");
+    if (equal != std::string::npos) {
+      values[pairs[i].substr(0, equal)] = pairs[i].substr(equal + 1);
+    }
+  }
+  return values;
+}
@@ -0,0 +1,187 @@
+#include "SessionSnapshot.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Error.hpp"
+#include "FileOpenException.hpp"
+#include "utility.hpp"
+
+namespace {
+bool isEarlier(const Session* lhs, const Session* rhs) {
+  return lhs->getTimeout() < rhs->getTimeout();
+}
+}  // namespace
+
+SessionSnapshot::SessionSnapshot(const std::string& path)
+    : path_(path), fd_(DEFAULT_FD), records_(0) {
+  open();
+}
+
+SessionSnapshot::~SessionSnapshot() {
+  flush();
+  close(fd_);
+}
+
+/*======================//
+ load
+========================*/
+
+/* replay the records into the sessions still alive, the first to expire
+first. a record cut short by a crash ends the replay */
+void SessionSnapshot::load(std::vector<Session*>& sessions,
+                           std::time_t now) {
+  std::string content;
+  try {
+    content = readFile(path_);
+  } catch (FileOpenException& e) {
+    return;
+  }
+  std::map<std::string, Session*> live;
+  std::size_t pos = 0;
+  while (true) {
+    std::size_t end = content.find("\n", pos);
+    if (end == std::string::npos) {
+      break;
+    }
+    std::vector<std::string> fields =
+        split(content.substr(pos, end - pos), " ");
+    pos = end + 1;
+    if (fields.size() == 4 && fields[0] == "+" && isNumber(fields[2]) &&
+        isNumber(fields[3]) && ::stoi(fields[3]) < content.size() - pos) {
+      std::size_t length = ::stoi(fields[3]);
+      Session* session =
+          new Session(fields[1], Session::decode(content.substr(pos, length)));
+      session->setTimeout(::stoi(fields[2]) - SESSION_TIMEOUT);
+      delete live[fields[1]];
+      live[fields[1]] = session;
+      pos += length + 1;
+    } else if (fields.size() == 2 && fields[0] == "-") {
+      delete live[fields[1]];
+      live.erase(fields[1]);
+    } else if (fields.size() == 3 && fields[0] == "~" &&
+               isNumber(fields[2])) {
+      std::map<std::string, Session*>::iterator it = live.find(fields[1]);
+      if (it != live.end() && it->second != NULL) {
+        it->second->setTimeout(::stoi(fields[2]) - SESSION_TIMEOUT);
+      }
+    } else {
+      break;
+    }
+  }
+  for (std::map<std::string, Session*>::iterator it = live.begin();
+       it != live.end(); ++it) {
+    if (it->second != NULL && now <= it->second->getTimeout()) {
+      sessions.push_back(it->second);
+    } else {
+      delete it->second;
+    }
+  }
+  std::sort(sessions.begin(), sessions.end(), isEarlier);
+}
+
+/*======================//
+ records
+========================*/
+
+void SessionSnapshot::append(const Session& session) {
+  refreshed_.erase(session.getID());
+  pending_ += encode(session);
+  records_ += 1;
+}
+
+void SessionSnapshot::remove(const std::string& id) {
+  refreshed_.erase(id);
+  pending_ += "- " + id + "\n";
+  records_ += 1;
+}
+
+/* only the last expiry of a tick is written */
+void SessionSnapshot::refresh(const Session& session) {
+  refreshed_[session.getID()] = session.getTimeout();
+}
+
+void SessionSnapshot::flush(void) {
+  for (std::map<std::string, std::time_t>::iterator it = refreshed_.begin();
+       it != refreshed_.end(); ++it) {
+    pending_ += "~ " + it->first + " " + toString(it->second) + "\n";
+    records_ += 1;
+  }
+  refreshed_.clear();
+  write(fd_, pending_);
+  pending_.clear();
+}
+
+/*======================//
+ compaction
+========================*/
+
+bool SessionSnapshot::isBloated(std::size_t live) const {
+  return SESSION_SNAPSHOT_MIN_RECORDS < records_ && live * 2 < records_;
+}
+
+/* one "+" record per live session, written aside and renamed into place
+so a crash leaves either the old file or the new one */
+void SessionSnapshot::compact(const std::list<Session*>& sessions) {
+  const std::string temporary = path_ + ".tmp";
+  std::string data;
+
+  for (std::list<Session*>::const_iterator it = sessions.begin();
+       it != sessions.end(); ++it) {
+    data += encode(**it);
+  }
+  int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0600);
+  if (fd == ERROR<int>()) {
+    return;
+  }
+  bool is_written = write(fd, data);
+  close(fd);
+  if (is_written == false ||
+      rename(temporary.c_str(), path_.c_str()) == ERROR<int>()) {
+    unlink(temporary.c_str());
+    return;
+  }
+  close(fd_);
+  open();
+  pending_.clear();
+  refreshed_.clear();
+  records_ = sessions.size();
+}
+
+/*======================//
+ utils
+========================*/
+
+void SessionSnapshot::open(void) {
+  fd_ = ::open(path_.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC,
+               0600);
+  if (fd_ == ERROR<int>()) {
+    Error::log(Error::INFO[EOPEN], path_, EXIT_FAILURE);
+  }
+}
+
+/* a failed write loses the records of one tick, not the file */
+bool SessionSnapshot::write(int fd, const std::string& data) {
+  std::size_t written = 0;
+  while (written < data.size()) {
+    ssize_t write_bytes =
+        ::write(fd, data.c_str() + written, data.size() - written);
+    if (write_bytes == ERROR<ssize_t>()) {
+      return false;
+    }
+    written += write_bytes;
+  }
+  return true;
+}
+
+std::string SessionSnapshot::encode(const Session& session) {
+  const std::string data = session.encode();
+
+  return "+ " + session.getID() + " " + toString(session.getTimeout()) + " " +
+         toString(data.size()) + "\n" + data + "\n";
+}
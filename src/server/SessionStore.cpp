@@ -0,0 +1,254 @@
+#include "SessionStore.hpp"
+
+#include "Clock.hpp"
+#include "constant.hpp"
+#include "exception.hpp"
+#include "utility.hpp"
+
+SessionStore::SessionStore(const std::string& shared_path,
+                           const std::string& snapshot_path)
+    : used_(0), deleted_(0), shared_(NULL), snapshot_(NULL) {
+  std::size_t size = 1;
+  while (size < SESSION_MAX_COUNT * 2) {
+    size <<= 1;
+  }
+  slots_.resize(size);
+  if (shared_path.empty() == false) {
+    shared_ = new SharedSessions(shared_path);
+  }
+  if (snapshot_path.empty() == false) {
+    snapshot_ = new SessionSnapshot(snapshot_path);
+    restore();
+  }
+}
+
+SessionStore::~SessionStore() {
+  for (std::list<Session*>::iterator it = lru_.begin(); it != lru_.end();
+       ++it) {
+    delete *it;
+  }
+  delete shared_;
+  delete snapshot_;
+}
+
+/*======================//
+ lookup
+========================*/
+
+/* the session of id, NULL if there is none or it expired */
+Session* SessionStore::find(const std::string& id, std::time_t now) {
+  stats_.lookups += 1;
+  std::size_t index = locateAlive(id, now);
+  if (index == NPOS) {
+    return NULL;
+  }
+  stats_.hits += 1;
+  return slots_[index].session;
+}
+
+/* find and refresh the session for another SESSION_TIMEOUT. the shared
+file has the last word on whether it is still alive */
+Session* SessionStore::touch(const std::string& id, std::time_t now) {
+  std::size_t index = locateAlive(id, now);
+  if (shared_ != NULL) {
+    Session::ValueType values;
+    if (shared_->load(id, now, values) == false) {
+      if (index != NPOS) {
+        remove(index);
+      }
+      return NULL;
+    }
+    if (index == NPOS) {
+      keep(new Session(id, values), now);
+      if (snapshot_ != NULL) {
+        snapshot_->append(*lru_.back());
+      }
+      return lru_.back();
+    }
+  }
+  if (index == NPOS) {
+    return NULL;
+  }
+  Slot& slot = slots_[index];
+  slot.session->setTimeout(now);
+  lru_.splice(lru_.end(), lru_, slot.lru);
+  if (snapshot_ != NULL) {
+    snapshot_->refresh(*slot.session);
+  }
+  return slot.session;
+}
+
+/*======================//
+ update
+========================*/
+
+/* the store owns the session from here on. a session the shared file can
+not take is refused, touch would take it for logged out */
+void SessionStore::insert(Session* session, std::time_t now) {
+  std::size_t index = locate(session->getID());
+  if (index != NPOS) {
+    remove(index);
+  }
+  if (shared_ != NULL && SharedSessions::fits(*session) == false) {
+    delete session;
+    throw ResponseException(C413);
+  }
+  if (shared_ != NULL && shared_->store(*session, now) == false) {
+    delete session;
+    throw ResponseException(C500);
+  }
+  keep(session, now);
+  if (snapshot_ != NULL) {
+    snapshot_->append(*session);
+  }
+  stats_.created += 1;
+}
+
+void SessionStore::erase(const std::string& id) {
+  std::size_t index = locate(id);
+  if (index != NPOS) {
+    remove(index);
+  }
+  if (shared_ != NULL) {
+    shared_->erase(id);
+  }
+  if (snapshot_ != NULL) {
+    snapshot_->remove(id);
+  }
+}
+
+/* drop the sessions that expired, oldest first */
+void SessionStore::sweep(std::time_t now) {
+  for (std::size_t count = 0;
+       count < SESSION_SWEEP_LIMIT && lru_.empty() == false &&
+       lru_.front()->getTimeout() < now;
+       ++count) {
+    remove(locate(lru_.front()->getID()));
+    stats_.expired += 1;
+  }
+  if (shared_ != NULL) {
+    shared_->sweep(now);
+  }
+  if (snapshot_ != NULL) {
+    snapshot_->flush();
+    if (snapshot_->isBloated(used_) == true) {
+      snapshot_->compact(lru_);
+    }
+  }
+}
+
+/*======================//
+ stats
+========================*/
+
+std::size_t SessionStore::size(void) const { return used_; }
+
+std::size_t SessionStore::capacity(void) const { return SESSION_MAX_COUNT; }
+
+const SessionStore::Stats& SessionStore::getStats(void) const {
+  return stats_;
+}
+
+/*======================//
+ table
+========================*/
+
+/* the sessions of the last run, compacted right away so the file starts
+from what survived */
+void SessionStore::restore(void) {
+  std::vector<Session*> sessions;
+
+  snapshot_->load(sessions, Clock::now());
+  for (std::size_t i = 0; i < sessions.size(); ++i) {
+    keep(sessions[i], sessions[i]->getTimeout() - SESSION_TIMEOUT);
+  }
+  snapshot_->compact(lru_);
+}
+
+/* make room by evicting the least recently used session, then place */
+void SessionStore::keep(Session* session, std::time_t now) {
+  if (SESSION_MAX_COUNT <= used_) {
+    if (snapshot_ != NULL) {
+      snapshot_->remove(lru_.front()->getID());
+    }
+    remove(locate(lru_.front()->getID()));
+    stats_.evicted += 1;
+  }
+  session->setTimeout(now);
+  place(session, lru_.insert(lru_.end(), session));
+}
+
+/* slot index holding id, NPOS if it is not stored */
+std::size_t SessionStore::locate(const std::string& id) const {
+  const std::size_t mask = slots_.size() - 1;
+  std::size_t index = fnv1a(id) & mask;
+
+  for (std::size_t probe = 0; probe < slots_.size(); ++probe) {
+    const Slot& slot = slots_[index];
+    if (slot.state == EMPTY) {
+      return NPOS;
+    }
+    if (slot.state == USED && slot.session->getID() == id) {
+      return index;
+    }
+    index = (index + 1) & mask;
+  }
+  return NPOS;
+}
+
+/* like locate, but an expired session is dropped and counts as absent */
+std::size_t SessionStore::locateAlive(const std::string& id,
+                                      std::time_t now) {
+  std::size_t index = locate(id);
+  if (index != NPOS && slots_[index].session->getTimeout() < now) {
+    remove(index);
+    stats_.expired += 1;
+    return NPOS;
+  }
+  return index;
+}
+
+/* the first free slot on the probe sequence of the id */
+void SessionStore::place(Session* session,
+                         std::list<Session*>::iterator lru) {
+  const std::size_t mask = slots_.size() - 1;
+  std::size_t index = fnv1a(session->getID()) & mask;
+
+  while (slots_[index].state == USED) {
+    index = (index + 1) & mask;
+  }
+  if (slots_[index].state == DELETED) {
+    deleted_ -= 1;
+  }
+  slots_[index].state = USED;
+  slots_[index].session = session;
+  slots_[index].lru = lru;
+  used_ += 1;
+}
+
+void SessionStore::remove(std::size_t index) {
+  Slot& slot = slots_[index];
+
+  lru_.erase(slot.lru);
+  delete slot.session;
+  slot.session = NULL;
+  slot.state = DELETED;
+  used_ -= 1;
+  deleted_ += 1;
+  if (slots_.size() / 4 < deleted_) {
+    rebuild();
+  }
+}
+
+/* drop the deleted markers that lengthen every probe */
+void SessionStore::rebuild(void) {
+  for (std::size_t i = 0; i < slots_.size(); ++i) {
+    slots_[i] = Slot();
+  }
+  used_ = 0;
+  deleted_ = 0;
+  for (std::list<Session*>::iterator it = lru_.begin(); it != lru_.end();
+       ++it) {
+    place(*it, it);
+  }
+}
@@ -0,0 +1,218 @@
+#include "SharedSessions.hpp"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include "Error.hpp"
+#include "utility.hpp"
+
+const char SharedSessions::MAGIC[8] = {'W', 'S', 'S', 'E', 'S', 'S', 'N', '1'};
+const std::size_t SharedSessions::LENGTH =
+    sizeof(Header) + SESSION_SHM_SHARDS * sizeof(Lock) +
+    SESSION_SHM_SLOTS * sizeof(Slot);
+
+SharedSessions::SharedSessions(const std::string& path)
+    : path_(path),
+      fd_(DEFAULT_FD),
+      header_(NULL),
+      locks_(NULL),
+      slots_(NULL),
+      next_shard_(0) {
+  map();
+}
+
+SharedSessions::~SharedSessions() {
+  munmap(header_, LENGTH);
+  close(fd_);
+}
+
+/*======================//
+ access
+========================*/
+
+/* false when the session does not fit a slot or its shard is full */
+bool SharedSessions::store(const Session& session, std::time_t now) {
+  if (fits(session) == false) {
+    return false;
+  }
+  const std::string& id = session.getID();
+  const std::string data = session.encode();
+  const uint64_t id_hash = fnv1a(id);
+  const std::size_t shard = id_hash % SESSION_SHM_SHARDS;
+
+  lock(shard);
+  Slot* slot = locate(id, id_hash, now, true);
+  if (slot != NULL) {
+    std::memset(slot->id, 0, SESSION_SHM_ID_SIZE);
+    std::memcpy(slot->id, id.data(), id.size());
+    std::memcpy(slot->data, data.data(), data.size());
+    slot->data_length = data.size();
+    slot->expires = session.getTimeout();
+    slot->state = USED;
+  }
+  unlock(shard);
+  return slot != NULL;
+}
+
+/* refresh the session for SESSION_TIMEOUT and copy its values out */
+bool SharedSessions::load(const std::string& id, std::time_t now,
+                          Session::ValueType& values) {
+  const uint64_t id_hash = fnv1a(id);
+  const std::size_t shard = id_hash % SESSION_SHM_SHARDS;
+
+  lock(shard);
+  Slot* slot = locate(id, id_hash, now, false);
+  if (slot != NULL) {
+    slot->expires = now + SESSION_TIMEOUT;
+    values = Session::decode(std::string(slot->data, slot->data_length));
+  }
+  unlock(shard);
+  return slot != NULL;
+}
+
+void SharedSessions::erase(const std::string& id) {
+  const uint64_t id_hash = fnv1a(id);
+  const std::size_t shard = id_hash % SESSION_SHM_SHARDS;
+
+  lock(shard);
+  Slot* slot = locate(id, id_hash, 0, false);
+  if (slot != NULL) {
+    slot->state = DELETED;
+  }
+  unlock(shard);
+}
+
+/* mark the expired slots of one shard as free, the next one next tick */
+void SharedSessions::sweep(std::time_t now) {
+  const std::size_t shard_size = SESSION_SHM_SLOTS / SESSION_SHM_SHARDS;
+  const std::size_t shard = next_shard_;
+
+  lock(shard);
+  for (std::size_t i = shard * shard_size; i < (shard + 1) * shard_size;
+       ++i) {
+    if (slots_[i].state == USED && slots_[i].expires < now) {
+      slots_[i].state = DELETED;
+    }
+  }
+  unlock(shard);
+  next_shard_ = (shard + 1) % SESSION_SHM_SHARDS;
+}
+
+/*======================//
+ region
+========================*/
+
+/* map the file, laying it out again when another layout wrote it. the
+file lock keeps two processes from laying it out at once */
+void SharedSessions::map(void) {
+  struct stat statbuf;
+
+  fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd_ == ERROR<int>() || flock(fd_, LOCK_EX) == ERROR<int>() ||
+      fstat(fd_, &statbuf) == ERROR<int>()) {
+    Error::log(Error::INFO[EOPEN], path_, EXIT_FAILURE);
+  }
+  bool is_resized = (static_cast<std::size_t>(statbuf.st_size) != LENGTH);
+  if (is_resized == true && (ftruncate(fd_, 0) == ERROR<int>() ||
+                             ftruncate(fd_, LENGTH) == ERROR<int>())) {
+    Error::log(Error::INFO[ESYSTEM], path_, EXIT_FAILURE);
+  }
+  void* address =
+      mmap(NULL, LENGTH, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (address == MAP_FAILED) {
+    Error::log(Error::INFO[ESYSTEM], path_, EXIT_FAILURE);
+  }
+  header_ = static_cast<Header*>(address);
+  locks_ = reinterpret_cast<Lock*>(header_ + 1);
+  slots_ = reinterpret_cast<Slot*>(locks_ + SESSION_SHM_SHARDS);
+  if (is_resized == true ||
+      std::memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header_->slots != SESSION_SHM_SLOTS ||
+      header_->shards != SESSION_SHM_SHARDS ||
+      header_->id_size != SESSION_SHM_ID_SIZE ||
+      header_->data_size != SESSION_SHM_DATA_SIZE) {
+    reset();
+  }
+  flock(fd_, LOCK_UN);
+}
+
+void SharedSessions::reset(void) {
+  std::memset(header_, 0, LENGTH);
+  std::memcpy(header_->magic, MAGIC, sizeof(MAGIC));
+  header_->slots = SESSION_SHM_SLOTS;
+  header_->shards = SESSION_SHM_SHARDS;
+  header_->id_size = SESSION_SHM_ID_SIZE;
+  header_->data_size = SESSION_SHM_DATA_SIZE;
+}
+
+/*======================//
+ shard
+========================*/
+
+/* linear probing inside the shard of the hash, with its lock held. an
+expired slot counts as free: a lookup frees it, an insert takes it */
+SharedSessions::Slot* SharedSessions::locate(const std::string& id,
+                                             uint64_t id_hash,
+                                             std::time_t now,
+                                             bool for_insert) {
+  const std::size_t shard_size = SESSION_SHM_SLOTS / SESSION_SHM_SHARDS;
+  const std::size_t base = (id_hash % SESSION_SHM_SHARDS) * shard_size;
+  const std::size_t start = (id_hash / SESSION_SHM_SHARDS) % shard_size;
+  Slot* free_slot = NULL;
+
+  for (std::size_t probe = 0; probe < shard_size; ++probe) {
+    Slot* slot = &slots_[base + (start + probe) % shard_size];
+    if (slot->state == EMPTY) {
+      return (for_insert == true && free_slot == NULL) ? slot : free_slot;
+    }
+    bool is_expired = (slot->state == USED && slot->expires < now);
+    if (slot->state == USED && std::strncmp(slot->id, id.c_str(),
+                                            SESSION_SHM_ID_SIZE) == 0) {
+      if (for_insert == true) {
+        return slot;
+      }
+      if (is_expired == true) {
+        slot->state = DELETED;
+        return NULL;
+      }
+      return slot;
+    }
+    if (for_insert == true && free_slot == NULL &&
+        (slot->state == DELETED || is_expired == true)) {
+      free_slot = slot;
+    }
+  }
+  return free_slot;
+}
+
+/* a holder only copies a slot, so spinning is short */
+void SharedSessions::lock(std::size_t shard) {
+  volatile int* value = &locks_[shard].value;
+
+  while (__sync_lock_test_and_set(value, 1) != 0) {
+    while (*value != 0) {
+      sched_yield();
+    }
+  }
+}
+
+void SharedSessions::unlock(std::size_t shard) {
+  __sync_lock_release(&locks_[shard].value);
+}
+
+/*======================//
+ utils
+========================*/
+
+/* whether the id and the encoded values fit the fixed size slot */
+bool SharedSessions::fits(const Session& session) {
+  return session.getID().size() < SESSION_SHM_ID_SIZE &&
+         session.encode().size() <= SESSION_SHM_DATA_SIZE;
+}
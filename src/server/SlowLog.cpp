@@ -0,0 +1,115 @@
+#include "SlowLog.hpp"
+
+#include <sys/wait.h>
+
+#include "AccessLog.hpp"
+#include "Client.hpp"
+#include "utility.hpp"
+
+SlowLog::SlowLog() : file_(NULL), threshold_(0) {}
+
+/* the threshold is given in milliseconds and kept in microseconds */
+SlowLog::SlowLog(const std::string& path, std::size_t threshold)
+    : file_(NULL), threshold_(static_cast<uint64_t>(threshold) * 1000) {
+  if (path.empty() == false) {
+    file_ = LogFile::open(path);
+  }
+}
+
+SlowLog::SlowLog(const SlowLog& origin)
+    : file_(origin.file_),
+      threshold_(origin.threshold_),
+      pending_(origin.pending_) {}
+
+SlowLog& SlowLog::operator=(const SlowLog& origin) {
+  if (this != &origin) {
+    file_ = origin.file_;
+    threshold_ = origin.threshold_;
+    pending_ = origin.pending_;
+  }
+  return *this;
+}
+
+SlowLog::~SlowLog() {}
+
+void SlowLog::write(const Client& client) {
+  if (file_ == NULL || client.getRequestTime() < threshold_) {
+    return;
+  }
+  std::string line = render(client);
+  const Process& process = client.getProcess();
+  if (client.getLocation().isCgi() == false || process.pid == 0) {
+    file_->append(line + "\n");
+    return;
+  }
+  line += " cgi=" + AccessLog::escape(client.getFullUri());
+  if (process.pool != NULL) {
+    file_->append(line + " worker=" + toString(process.pid) + "\n");
+    return;
+  }
+  line += " pid=" + toString(process.pid);
+  int status;
+  if (ProcessTable::findExit(process.pid, status) == true) {
+    file_->append(line + " " + describeExit(status) + "\n");
+    return;
+  }
+  Pending pending;
+  pending.pid = process.pid;
+  pending.since = Clock::now();
+  pending.line = line;
+  pending_.push_back(pending);
+}
+
+/* lines of scripts reaped since, or waited for long enough */
+void SlowLog::flush(std::time_t now) {
+  std::list<Pending>::iterator it = pending_.begin();
+  while (it != pending_.end()) {
+    int status;
+    if (ProcessTable::findExit(it->pid, status) == true) {
+      file_->append(it->line + " " + describeExit(status) + "\n");
+    } else if (ProcessTable::isRunning(it->pid) == false ||
+               now - it->since >= SLOW_LOG_EXIT_WAIT) {
+      file_->append(it->line + " exit=-\n");
+    } else {
+      ++it;
+      continue;
+    }
+    it = pending_.erase(it);
+  }
+}
+
+/*======================//
+ utils
+========================*/
+
+std::string SlowLog::render(const Client& client) const {
+  const HttpRequest& request = client.getRequest();
+  const SocketAddress address = client.getAddr();
+  const std::string& status = client.getStatusCode();
+  const std::string target = request.getMethod() + " " + request.getUri();
+  std::string line;
+
+  line += "[" + Clock::getLogDate() + "] ";
+  line += address.getIP() + ":" + address.getPort();
+  line += " \"" + AccessLog::escape(target) + "\"";
+  line += " status=" + (status.empty() ? "499" : status);
+  line += " time=" + AccessLog::toSeconds(client.getRequestTime());
+  for (std::size_t i = 0; i < Metrics::PHASE_COUNT; ++i) {
+    line += " ";
+    line += Metrics::PHASES[i];
+    line += "=" + AccessLog::toSeconds(client.getPhases()[i]);
+  }
+  line += " body=" + toString(request.getBody().size());
+  line += " bytes_sent=" + toString(client.getBytesSent());
+  if (client.getUpstream().empty() == false) {
+    line += " upstream=" + client.getUpstream();
+  }
+  return line;
+}
+
+std::string SlowLog::describeExit(int status) {
+  if (WIFSIGNALED(status)) {
+    return "signal=" + toString(WTERMSIG(status));
+  }
+  return "exit=" + toString(WEXITSTATUS(status));
+}
@@ -0,0 +1,115 @@
+#include "Clock.hpp"
+
+#include <cstring>
+
+const char* const Clock::DAYS[] = {"Sun", "Mon", "Tue", "Wed",
+                                   "Thu", "Fri", "Sat"};
+const char* const Clock::MONTHS[] = {"Jan", "Feb", "Mar", "Apr",
+                                     "May", "Jun", "Jul", "Aug",
+                                     "Sep", "Oct", "Nov", "Dec"};
+
+std::time_t Clock::now_ = std::time(NULL);
+std::time_t Clock::date_time_ = -1;
+std::string Clock::date_;
+std::time_t Clock::log_date_time_ = -1;
+std::string Clock::log_date_;
+
+void Clock::update(void) { now_ = std::time(NULL); }
+
+std::time_t Clock::now(void) { return now_; }
+
+/* the date of the current second, formatted once per second */
+const std::string& Clock::getHttpDate(void) {
+  if (date_time_ != now_) {
+    date_ = formatHttpDate(now_);
+    date_time_ = now_;
+  }
+  return date_;
+}
+
+/* IMF-fixdate of RFC 7231, "Sun, 06 Nov 1994 08:49:37 GMT" */
+std::string Clock::formatHttpDate(std::time_t time) {
+  struct tm gmt;
+  char date[30];
+
+  gmtime_r(&time, &gmt);
+  date[0] = DAYS[gmt.tm_wday][0];
+  date[1] = DAYS[gmt.tm_wday][1];
+  date[2] = DAYS[gmt.tm_wday][2];
+  date[3] = ',';
+  date[4] = ' ';
+  date[5] = '0' + gmt.tm_mday / 10;
+  date[6] = '0' + gmt.tm_mday % 10;
+  date[7] = ' ';
+  date[8] = MONTHS[gmt.tm_mon][0];
+  date[9] = MONTHS[gmt.tm_mon][1];
+  date[10] = MONTHS[gmt.tm_mon][2];
+  date[11] = ' ';
+  int year = gmt.tm_year + 1900;
+  date[12] = '0' + year / 1000 % 10;
+  date[13] = '0' + year / 100 % 10;
+  date[14] = '0' + year / 10 % 10;
+  date[15] = '0' + year % 10;
+  date[16] = ' ';
+  date[17] = '0' + gmt.tm_hour / 10;
+  date[18] = '0' + gmt.tm_hour % 10;
+  date[19] = ':';
+  date[20] = '0' + gmt.tm_min / 10;
+  date[21] = '0' + gmt.tm_min % 10;
+  date[22] = ':';
+  date[23] = '0' + gmt.tm_sec / 10;
+  date[24] = '0' + gmt.tm_sec % 10;
+  date[25] = ' ';
+  date[26] = 'G';
+  date[27] = 'M';
+  date[28] = 'T';
+  return std::string(date, 29);
+}
+
+/* the log date of the current second, formatted once per second */
+const std::string& Clock::getLogDate(void) {
+  if (log_date_time_ != now_) {
+    log_date_ = formatLogDate(now_);
+    log_date_time_ = now_;
+  }
+  return log_date_;
+}
+
+/* common log format in GMT, "06/Nov/1994:08:49:37 +0000" */
+std::string Clock::formatLogDate(std::time_t time) {
+  struct tm gmt;
+  char date[26];
+
+  gmtime_r(&time, &gmt);
+  date[0] = '0' + gmt.tm_mday / 10;
+  date[1] = '0' + gmt.tm_mday % 10;
+  date[2] = '/';
+  date[3] = MONTHS[gmt.tm_mon][0];
+  date[4] = MONTHS[gmt.tm_mon][1];
+  date[5] = MONTHS[gmt.tm_mon][2];
+  date[6] = '/';
+  int year = gmt.tm_year + 1900;
+  date[7] = '0' + year / 1000 % 10;
+  date[8] = '0' + year / 100 % 10;
+  date[9] = '0' + year / 10 % 10;
+  date[10] = '0' + year % 10;
+  date[11] = ':';
+  date[12] = '0' + gmt.tm_hour / 10;
+  date[13] = '0' + gmt.tm_hour % 10;
+  date[14] = ':';
+  date[15] = '0' + gmt.tm_min / 10;
+  date[16] = '0' + gmt.tm_min % 10;
+  date[17] = ':';
+  date[18] = '0' + gmt.tm_sec / 10;
+  date[19] = '0' + gmt.tm_sec % 10;
+  std::memcpy(date + 20, " +0000", 6);
+  return std::string(date, 26);
+}
+
+/* monotonic, so a wall clock step never makes a duration negative */
+uint64_t Clock::getMicroseconds(void) {
+  struct timespec time;
+
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<uint64_t>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+}
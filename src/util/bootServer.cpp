@@ -15,7 +15,10 @@ static void printLogo() {
 /* handle a signals */
 static void registerSignalHandlers() {
   signal(SIGPIPE, SIG_IGN);
-  signal(SIGCHLD, SIG_IGN);
+  signal(SIGCHLD, SIG_DFL);
+  signal(SIGUSR1, SIG_IGN);
+  signal(SIGTERM, SIG_IGN);
+  signal(SIGINT, SIG_IGN);
 }
 
 /* parse configuration file and create Config instance */
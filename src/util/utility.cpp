@@ -1,21 +1,92 @@
 #include "utility.hpp"
 
 #include <dirent.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
+#include <cctype>
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <fstream>
 
 #include "exception.hpp"
 
+/* "gzip, br;q=0.5" accepts both; q=0 or a missing coding refuses */
+bool acceptsEncoding(const std::string& accept_encoding,
+                     const std::string& coding) {
+  std::vector<std::string> codings = split(accept_encoding, ",");
+  for (std::size_t i = 0; i < codings.size(); ++i) {
+    std::vector<std::string> params = split(codings[i], ";");
+    if (params.empty() == true) {
+      continue;
+    }
+    std::string name = toLower(trim(params[0]));
+    if (name != coding && name != "*") {
+      continue;
+    }
+    for (std::size_t j = 1; j < params.size(); ++j) {
+      std::string param = trim(params[j]);
+      if (param.compare(0, 2, "q=") == 0 &&
+          std::strtod(param.c_str() + 2, NULL) <= 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
 std::string formatTime(const char* format, std::time_t timestamp) {
   char buf[80];
   std::strftime(buf, sizeof(buf), format, std::localtime(&timestamp));
   return buf;
 }
 
+/* a GMT timestamp written with format, -1 if it does not match */
+std::time_t parseTime(const char* format, const std::string& value) {
+  struct tm time;
+
+  std::memset(&time, 0, sizeof(time));
+  const char* end = strptime(value.c_str(), format, &time);
+  if (end == NULL || *end != '\0') {
+    return ERROR<std::time_t>();
+  }
+  return timegm(&time);
+}
+
+/* position of the blank line ending a header, NPOS if not yet */
+std::size_t findHeaderEnd(const std::string& message,
+                          std::size_t& separator_size) {
+  std::size_t lf = message.find(DOUBLE_LF);
+  std::size_t crlf = message.find(DOUBLE_CRLF);
+
+  if (crlf < lf) {
+    separator_size = DOUBLE_CRLF.size();
+    return crlf;
+  }
+  separator_size = DOUBLE_LF.size();
+  return lf;
+}
+
+/* FNV-1a, 64 bits */
+uint64_t fnv1a(const std::string& data) {
+  const uint64_t prime = (static_cast<uint64_t>(1) << 40) + 0x1b3;
+  uint64_t value = (static_cast<uint64_t>(0xcbf29ce4) << 32) | 0x84222325;
+
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    value ^= static_cast<unsigned char>(data[i]);
+    value *= prime;
+  }
+  return value;
+}
+
 std::size_t hexToInt(const std::string& value) {
   std::size_t out;
   std::istringstream iss(value);
@@ -71,6 +142,28 @@ int removeDirectory(const std::string& path) {
   return error;
 }
 
+/* send up to size bytes of fd from offset to a socket without copying
+them through user space, -1 on error */
+ssize_t sendFile(int socket, int fd, off_t offset, std::size_t size) {
+#if defined(__linux__)
+  return sendfile(socket, fd, &offset, size);
+#elif defined(__APPLE__)
+  off_t length = size;
+  if (sendfile(fd, socket, offset, &length, NULL, 0) == ERROR<int>() &&
+      length == 0) {
+    return ERROR<ssize_t>();
+  }
+  return length;
+#else
+  off_t length = 0;
+  if (sendfile(fd, socket, offset, size, NULL, &length, 0) == ERROR<int>() &&
+      length == 0) {
+    return ERROR<ssize_t>();
+  }
+  return length;
+#endif
+}
+
 std::vector<std::string> split(const std::string& content,
                                const std::string& delim) {
   std::vector<std::string> substrings;
@@ -115,6 +208,20 @@ std::size_t stoi(const std::string& value) {
   return num;
 }
 
+std::string toHex(std::size_t value) {
+  std::ostringstream oss;
+  oss << std::hex << value;
+  return oss.str();
+}
+
+std::string toLower(const std::string& str) {
+  std::string lower(str);
+  for (std::size_t i = 0; i < lower.size(); ++i) {
+    lower[i] = std::tolower(lower[i]);
+  }
+  return lower;
+}
+
 std::string trim(const std::string& str) {
   std::size_t start = str.find_first_not_of(WHITESPACE);
   std::size_t end = str.find_last_not_of(WHITESPACE);